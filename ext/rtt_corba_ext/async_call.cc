@@ -0,0 +1,440 @@
+#include "async_call.hh"
+#include "parallel_calls.hh"
+#include "rtt-corba.hh"
+
+#include <atomic>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <fcntl.h>
+#include <map>
+#include <stdarg.h>
+#include <typeinfo>
+#include <unistd.h>
+
+using namespace runkit;
+
+static VALUE cAsyncCall;
+
+AsyncCall::AsyncCall()
+    : done(false)
+    , failure_reported(false)
+    , call_timeout(current_call_timeout())
+    , task(Qnil)
+    , exception_class(Qnil)
+{
+    wait_fds[0] = -1;
+    wait_fds[1] = -1;
+}
+
+AsyncCall::~AsyncCall()
+{
+    if (wait_fds[0] != -1) {
+        close(wait_fds[0]);
+        close(wait_fds[1]);
+    }
+}
+
+void AsyncCall::execute()
+{
+    try {
+        ThreadCallTimeout timeout(call_timeout);
+        run();
+    }
+    CORBA_EXCEPTION_HANDLERS
+    EXCEPTION_HANDLERS
+    catch (...) {
+        rb_raise(eCORBA, "unknown exception in asynchronous call");
+    }
+    finish();
+}
+
+void AsyncCall::cancel()
+{
+    rb_raise(eCORBA, "the call got interrupted before it started");
+    finish();
+}
+
+void AsyncCall::finish()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    done = true;
+    if (wait_fds[1] != -1) {
+        char byte = 0;
+        ssize_t ret = write(wait_fds[1], &byte, 1);
+        (void)ret;
+    }
+}
+
+bool AsyncCall::isDone()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return done;
+}
+
+int AsyncCall::getWaitFD()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    if (done)
+        return -1;
+    if (wait_fds[0] != -1)
+        return wait_fds[0];
+
+    if (pipe(wait_fds) == -1) {
+        wait_fds[0] = -1;
+        wait_fds[1] = -1;
+        return -2;
+    }
+    for (int i = 0; i < 2; ++i) {
+        fcntl(wait_fds[i], F_SETFL, fcntl(wait_fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wait_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    return wait_fds[0];
+}
+
+VALUE AsyncCall::value()
+{
+    VALUE error = exception();
+    if (!NIL_P(error))
+        rb_exc_raise(error);
+    return toRuby();
+}
+
+VALUE AsyncCall::exception()
+{
+    if (!RTEST(exception_class))
+        return Qnil;
+    if (exception_message.empty())
+        return rb_exc_new_cstr(exception_class, rb_class2name(exception_class));
+    return rb_exc_new(exception_class,
+        exception_message.c_str(),
+        exception_message.size());
+}
+
+void AsyncCall::reportFailure()
+{
+    if (failure_reported)
+        return;
+    failure_reported = true;
+    if (RTEST(exception_class) && !NIL_P(task))
+        task_call_failed(&get_wrapped<RTaskContext>(task), exception_class);
+}
+
+void AsyncCall::mark()
+{
+}
+
+void AsyncCall::setTask(VALUE task)
+{
+    this->task = task;
+}
+
+VALUE AsyncCall::getTask() const
+{
+    return task;
+}
+
+void AsyncCall::rb_raise(VALUE exception_class)
+{
+    this->exception_class = exception_class;
+    this->exception_message.clear();
+}
+
+void AsyncCall::rb_raise(VALUE exception_class, const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, 256, format, args);
+    va_end(args);
+
+    this->exception_class = exception_class;
+    this->exception_message = buffer;
+}
+
+void AsyncCall::rb_raise(VALUE exception_class, std::string const& message)
+{
+    this->exception_class = exception_class;
+    this->exception_message = message;
+}
+
+namespace {
+    /** Fixed pool of threads that execute the AsyncCall objects and the
+     * ParallelCalls jobs
+     */
+    class AsyncCallEngine {
+    public:
+        typedef boost::function<void()> Job;
+
+        AsyncCallEngine(size_t worker_count)
+        {
+            for (size_t i = 0; i < worker_count; ++i)
+                workers.create_thread(boost::bind(&AsyncCallEngine::work, this));
+        }
+
+        void submit(Job const& job)
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            queue.push_back(job);
+            cond.notify_one();
+        }
+
+    private:
+        boost::thread_group workers;
+        boost::mutex mutex;
+        boost::condition_variable cond;
+        std::deque<Job> queue;
+
+        void work()
+        {
+            while (true) {
+                Job job;
+                {
+                    boost::mutex::scoped_lock lock(mutex);
+                    while (queue.empty())
+                        cond.wait(lock);
+                    job = queue.front();
+                    queue.pop_front();
+                }
+                job();
+            }
+        }
+    };
+
+    size_t async_worker_count = 8;
+    // The engine is created on first use, and lives until the end of the
+    // process. It may be created from a thread that does not hold the GVL
+    // (see submit_worker_job), hence the mutex
+    boost::mutex async_engine_mutex;
+    AsyncCallEngine* async_engine = NULL;
+
+    AsyncCallEngine& get_async_engine()
+    {
+        boost::mutex::scoped_lock lock(async_engine_mutex);
+        if (!async_engine)
+            async_engine = new AsyncCallEngine(async_worker_count);
+        return *async_engine;
+    }
+
+    typedef boost::shared_ptr<AsyncCall> AsyncCallPtr;
+
+    void async_call_mark(AsyncCallPtr* call)
+    {
+        rb_gc_mark((*call)->getTask());
+        (*call)->mark();
+    }
+
+    void async_call_free(AsyncCallPtr* call)
+    {
+        delete call;
+    }
+}
+
+void runkit::submit_worker_job(boost::function<void()> const& job)
+{
+    get_async_engine().submit(job);
+}
+
+size_t runkit::worker_pool_size()
+{
+    boost::mutex::scoped_lock lock(async_engine_mutex);
+    return async_worker_count;
+}
+
+VALUE runkit::async_call_start(boost::shared_ptr<AsyncCall> call)
+{
+    AsyncCallEngine& engine = get_async_engine();
+    VALUE obj = Data_Wrap_Struct(cAsyncCall,
+        async_call_mark,
+        async_call_free,
+        new AsyncCallPtr(call));
+    engine.submit(boost::bind(&AsyncCall::execute, call));
+    return obj;
+}
+
+namespace {
+    typedef std::vector<std::vector<size_t>> Lanes;
+
+    void run_lane(AsyncCalls& calls,
+        Lanes const& lanes,
+        std::atomic<bool> const& aborted,
+        size_t i)
+    {
+        for (size_t j = 0; j < lanes[i].size(); ++j) {
+            if (aborted)
+                calls[lanes[i][j]]->cancel();
+            else
+                calls[lanes[i][j]]->execute();
+        }
+    }
+
+    void run_lanes(AsyncCalls& calls,
+        Lanes const& lanes,
+        std::atomic<bool> const& aborted,
+        size_t max_threads)
+    {
+        ParallelCalls(lanes.size(),
+            boost::bind(&run_lane,
+                boost::ref(calls),
+                boost::cref(lanes),
+                boost::cref(aborted),
+                _1),
+            max_threads)
+            .run();
+    }
+
+    /** Called by Ruby to interrupt a batch. The calls in progress cannot be
+     * interrupted, but the ones that did not start yet get cancelled
+     */
+    void abort_lanes(std::atomic<bool>& aborted)
+    {
+        aborted = true;
+    }
+
+    VALUE protected_call_value(VALUE call)
+    {
+        return reinterpret_cast<AsyncCall*>(call)->value();
+    }
+
+    VALUE execute_lanes(AsyncCalls& calls, Lanes const& lanes, size_t max_threads)
+    {
+        std::atomic<bool> aborted(false);
+        blocking_fct_call(boost::bind(&run_lanes,
+                              boost::ref(calls),
+                              boost::cref(lanes),
+                              boost::cref(aborted),
+                              max_threads),
+            boost::bind(&abort_lanes, boost::ref(aborted)));
+
+        // Converting a result may raise. Report it as the call's error,
+        // instead of letting it skip the destruction of the calls
+        VALUE result = rb_ary_new_capa(calls.size());
+        for (size_t i = 0; i < calls.size(); ++i) {
+            calls[i]->reportFailure();
+            VALUE error = calls[i]->exception();
+            if (!NIL_P(error)) {
+                rb_ary_push(result, error);
+                continue;
+            }
+
+            int state = 0;
+            VALUE value = rb_protect(&protected_call_value,
+                reinterpret_cast<VALUE>(calls[i].get()),
+                &state);
+            if (state) {
+                value = rb_errinfo();
+                if (!rb_obj_is_kind_of(value, rb_eStandardError)) {
+                    // Not an error of the conversion (e.g. the thread is
+                    // being killed). Delete the calls before re-raising it
+                    AsyncCalls().swap(calls);
+                    rb_jump_tag(state);
+                }
+                rb_set_errinfo(Qnil);
+            }
+            rb_ary_push(result, value);
+        }
+        return result;
+    }
+}
+
+VALUE runkit::async_calls_execute(AsyncCalls& calls, size_t max_threads)
+{
+    Lanes lanes(calls.size());
+    for (size_t i = 0; i < calls.size(); ++i)
+        lanes[i].push_back(i);
+    return execute_lanes(calls, lanes, max_threads);
+}
+
+VALUE runkit::async_calls_execute(AsyncCalls& calls,
+    std::vector<size_t> const& call_lanes,
+    size_t max_threads)
+{
+    std::map<size_t, std::vector<size_t>> lanes_by_id;
+    for (size_t i = 0; i < calls.size(); ++i)
+        lanes_by_id[call_lanes[i]].push_back(i);
+
+    Lanes lanes;
+    lanes.reserve(lanes_by_id.size());
+    for (std::map<size_t, std::vector<size_t>>::const_iterator it = lanes_by_id.begin();
+         it != lanes_by_id.end();
+         ++it)
+        lanes.push_back(it->second);
+    return execute_lanes(calls, lanes, max_threads);
+}
+
+static VALUE async_call_done_p(VALUE self)
+{
+    return get_wrapped<AsyncCallPtr>(self)->isDone() ? Qtrue : Qfalse;
+}
+
+/** call-seq:
+ *     do_wait_fd => fd or nil
+ *
+ * Returns a file descriptor that becomes readable once the call is finished,
+ * or nil if it already is
+ */
+static VALUE async_call_wait_fd(VALUE self)
+{
+    int fd = get_wrapped<AsyncCallPtr>(self)->getWaitFD();
+    if (fd == -2)
+        rb_sys_fail("failed to create the completion pipe");
+    return fd == -1 ? Qnil : INT2FIX(fd);
+}
+
+static VALUE async_call_value(VALUE self)
+{
+    AsyncCall& call = *get_wrapped<AsyncCallPtr>(self);
+    if (!call.isDone())
+        rb_raise(rb_eRuntimeError, "the call is not finished yet");
+    call.reportFailure();
+    return call.value();
+}
+
+/** call-seq:
+ *     Runkit::CORBA.async_worker_count = count
+ *
+ * Sets the number of threads used to execute asynchronous and batched calls.
+ * It can only be changed before the first such call
+ */
+static VALUE async_set_worker_count(VALUE mod, VALUE count)
+{
+    int worker_count = NUM2INT(count);
+    if (worker_count < 1)
+        rb_raise(rb_eArgError, "there must be at least one async worker");
+
+    bool started;
+    {
+        boost::mutex::scoped_lock lock(async_engine_mutex);
+        started = async_engine;
+        if (!started)
+            async_worker_count = worker_count;
+    }
+    if (started)
+        rb_raise(rb_eArgError,
+            "the number of async workers cannot be changed after the first "
+            "asynchronous or batched call");
+    return count;
+}
+
+static VALUE async_get_worker_count(VALUE mod)
+{
+    return SIZET2NUM(worker_pool_size());
+}
+
+void runkit::rtt_corba_init_async_call(VALUE mRoot, VALUE mCORBA)
+{
+    cAsyncCall = rb_define_class_under(mRoot, "AsyncCall", rb_cObject);
+    rb_undef_alloc_func(cAsyncCall);
+    rb_define_method(cAsyncCall, "done?", RUBY_METHOD_FUNC(async_call_done_p), 0);
+    rb_define_method(cAsyncCall, "do_wait_fd", RUBY_METHOD_FUNC(async_call_wait_fd), 0);
+    rb_define_method(cAsyncCall, "do_value", RUBY_METHOD_FUNC(async_call_value), 0);
+
+    rb_define_singleton_method(mCORBA,
+        "async_worker_count=",
+        RUBY_METHOD_FUNC(async_set_worker_count),
+        1);
+    rb_define_singleton_method(mCORBA,
+        "async_worker_count",
+        RUBY_METHOD_FUNC(async_get_worker_count),
+        0);
+}
@@ -0,0 +1,139 @@
+#ifndef RUNKIT_CORBA_EXT_ASYNC_CALL_HH
+#define RUNKIT_CORBA_EXT_ASYNC_CALL_HH
+
+#include "corba.hh"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+namespace runkit {
+    /** A remote call executed by a pool of worker threads
+     *
+     * Subclasses implement run(), which is called from one of the workers
+     * without the GVL, and toRuby(), which is called from Ruby once the call
+     * is finished to convert its result. Exceptions thrown by run() are
+     * converted using the same handlers than the blocking calls, and raised
+     * by value()
+     *
+     * The call timeout set by Runkit::CORBA.with_call_timeout when the call
+     * is created applies to its execution
+     */
+    class AsyncCall {
+    public:
+        AsyncCall();
+        virtual ~AsyncCall();
+
+        /** Executes the call and marks it as done. Called by the workers */
+        void execute();
+
+        /** Marks the call as done without executing it, with an error
+         *
+         * It is used for the calls of a batch that got interrupted before
+         * they started
+         */
+        void cancel();
+
+        bool isDone();
+
+        /** Returns a file descriptor that becomes readable once the call is
+         * finished, or -1 if it already is
+         *
+         * The descriptor is created on the first call, and closed when this
+         * object is deleted
+         */
+        int getWaitFD();
+
+        /** Returns the call's result, or raises its error
+         *
+         * Must be called from Ruby, once the call is done
+         */
+        VALUE value();
+
+        /** Returns the exception object for the call's error, or nil if the
+         * call succeeded
+         *
+         * Must be called from Ruby, once the call is done
+         */
+        VALUE exception();
+
+        /** Removes the call's task from the table of task contexts indexed
+         * by IOR if the call failed with a communication error
+         *
+         * The error is recorded without the GVL, so this is done when the
+         * result is collected. Must be called from Ruby, once the call is
+         * done. Only the first call has an effect
+         */
+        void reportFailure();
+
+        /** Marks the Ruby objects this call refers to */
+        virtual void mark();
+
+        /** Sets the Ruby task context the call is made on
+         *
+         * If the call fails with a communication error, the task is removed
+         * from the table of task contexts indexed by IOR (see reportFailure).
+         * The task is marked as long as the call exists
+         */
+        void setTask(VALUE task);
+        VALUE getTask() const;
+
+        // Interface expected by CORBA_EXCEPTION_HANDLERS and EXCEPTION_HANDLERS
+        void rb_raise(VALUE exception_class);
+        void rb_raise(VALUE exception_class, const char* format, ...);
+        void rb_raise(VALUE exception_class, std::string const& message);
+
+    protected:
+        virtual void run() = 0;
+        virtual VALUE toRuby() = 0;
+
+    private:
+        void finish();
+
+        boost::mutex mutex;
+        bool done;
+        bool failure_reported;
+        int wait_fds[2];
+        CORBA::ULong call_timeout;
+        VALUE task;
+        VALUE exception_class;
+        std::string exception_message;
+    };
+
+    /** Queues a call for execution by the worker pool, and returns the
+     * Runkit::AsyncCall object that represents it in Ruby
+     */
+    VALUE async_call_start(boost::shared_ptr<AsyncCall> call);
+
+    typedef std::vector<boost::shared_ptr<AsyncCall>> AsyncCalls;
+
+    /** Executes the given calls in parallel on up to max_threads threads,
+     * with the GVL released only once
+     *
+     * If the Ruby thread gets interrupted, the calls that did not start yet
+     * are cancelled (see AsyncCall::cancel)
+     *
+     * The calls are executed by the calling thread and by the worker pool
+     * (see ParallelCalls), so max_threads is clamped to the pool size + 1
+     *
+     * Returns a Ruby array with, for each call, either its value or the
+     * exception object for its error
+     */
+    VALUE async_calls_execute(AsyncCalls& calls, size_t max_threads);
+
+    /** Executes the given calls with the GVL released only once
+     *
+     * The calls that have the same lane identifier in call_lanes are
+     * executed one after the other, in order. The lanes are executed in
+     * parallel on up to max_threads threads.
+     *
+     * Returns a Ruby array with, for each call, either its value or the
+     * exception object for its error
+     */
+    VALUE async_calls_execute(AsyncCalls& calls,
+        std::vector<size_t> const& call_lanes,
+        size_t max_threads);
+}
+
+#endif
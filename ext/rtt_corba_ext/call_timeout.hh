@@ -0,0 +1,53 @@
+#ifndef RUNKIT_CORBA_EXT_CALL_TIMEOUT_HH
+#define RUNKIT_CORBA_EXT_CALL_TIMEOUT_HH
+
+#include <omniORB4/CORBA.h>
+
+namespace runkit {
+    /** Sets the timeout of the CORBA calls made by the calling thread for the
+     * lifetime of this object. A timeout of zero keeps the current timeout
+     *
+     * The previous timeout is restored on destruction, so that the objects
+     * can be nested
+     */
+    class ThreadCallTimeout {
+        bool active;
+        CORBA::ULong previous;
+
+        static CORBA::ULong& threadTimeout()
+        {
+            static thread_local CORBA::ULong timeout = 0;
+            return timeout;
+        }
+
+    public:
+        ThreadCallTimeout(CORBA::ULong timeout)
+            : active(timeout != 0)
+            , previous(threadTimeout())
+        {
+            if (active) {
+                omniORB::setClientThreadCallTimeout(timeout);
+                threadTimeout() = timeout;
+            }
+        }
+        ~ThreadCallTimeout()
+        {
+            if (active) {
+                omniORB::setClientThreadCallTimeout(previous);
+                threadTimeout() = previous;
+            }
+        }
+
+        /** Returns the timeout set on the calling thread by the innermost
+         * ThreadCallTimeout object, or zero if there is none
+         *
+         * Unlike current_call_timeout, it does not need the GVL
+         */
+        static CORBA::ULong current()
+        {
+            return threadTimeout();
+        }
+    };
+}
+
+#endif
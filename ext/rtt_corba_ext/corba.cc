@@ -9,9 +9,11 @@
 #include <rtt/transports/corba/TransportPlugin.hpp>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
 #include <rtt/Activity.hpp>
 
 #include "corba.hh"
+#include "lib/corba_name_service.hh"
 #include "lib/corba_name_service_client.hh"
 #include "rtt-corba.hh"
 
@@ -46,6 +48,56 @@ CorbaAccess::~CorbaAccess()
     RTT::corba::TaskContextServer::ShutdownOrb(true);
 }
 
+namespace {
+    typedef std::map<std::string, CollocatedTaskPtr> CollocatedTasks;
+    CollocatedTasks collocated_tasks;
+    bool collocation_enabled = false;
+    // Protects embedded_name_service. The name service gets constructed
+    // without the GVL, so the GVL alone does not serialize its creation
+    boost::mutex embedded_name_service_mutex;
+    corba::NameService* embedded_name_service = NULL;
+
+    void delete_embedded_name_service()
+    {
+        boost::mutex::scoped_lock lock(embedded_name_service_mutex);
+        delete embedded_name_service;
+        embedded_name_service = NULL;
+    }
+}
+
+size_t runkit::collocated_call_count = 0;
+
+void runkit::register_collocated_task(std::string const& ior, RTT::TaskContext* task)
+{
+    CollocatedTaskPtr collocated(new CollocatedTask);
+    collocated->task = task;
+    collocated_tasks[ior] = collocated;
+}
+
+void runkit::unregister_collocated_task(RTT::TaskContext* task)
+{
+    for (CollocatedTasks::iterator it = collocated_tasks.begin();
+         it != collocated_tasks.end();
+         ++it) {
+        if (it->second->task == task) {
+            it->second->task = 0;
+            collocated_tasks.erase(it);
+            return;
+        }
+    }
+}
+
+CollocatedTaskPtr runkit::find_collocated_task(std::string const& ior)
+{
+    if (!collocation_enabled)
+        return CollocatedTaskPtr();
+
+    CollocatedTasks::const_iterator it = collocated_tasks.find(ior);
+    if (it == collocated_tasks.end())
+        return CollocatedTaskPtr();
+    return it->second;
+}
+
 RTaskContext* CorbaAccess::createRTaskContext(std::string const& ior)
 {
     std::unique_ptr<RTaskContext> new_context(new RTaskContext);
@@ -83,12 +135,53 @@ RTT::corba::CTaskContext_var CorbaAccess::getCTaskContext(std::string const& ior
     return mtask;
 }
 
+/** call-seq:
+ *     Runkit::CORBA.collocation = flag
+ *
+ * Controls whether the task contexts created from then on call the Ruby tasks
+ * of this process directly, instead of going through CORBA. It is disabled by
+ * default.
+ *
+ * Task contexts created for the same IOR share their underlying object only
+ * if they were created with the same setting
+ */
+static VALUE corba_set_collocation(VALUE mod, VALUE flag)
+{
+    collocation_enabled = RTEST(flag);
+    return flag;
+}
+
+static VALUE corba_collocation_p(VALUE mod)
+{
+    return collocation_enabled ? Qtrue : Qfalse;
+}
+
+/** call-seq:
+ *     Runkit::CORBA.collocated_call_count => count
+ *
+ * The number of times a call found the Ruby task of this process it is made
+ * on, and could therefore call it directly instead of going through CORBA
+ */
+static VALUE corba_collocated_call_count(VALUE mod)
+{
+    return SIZET2NUM(collocated_call_count);
+}
+
 static VALUE corba_set_call_timeout(VALUE mod, VALUE duration)
 {
     omniORB::setClientCallTimeout(NUM2INT(duration));
     return Qnil;
 }
 
+CORBA::ULong runkit::current_call_timeout()
+{
+    static ID id_call_timeout = rb_intern("__runkit_call_timeout");
+    VALUE timeout = rb_thread_local_aref(rb_thread_current(), id_call_timeout);
+    if (NIL_P(timeout))
+        return 0;
+    return NUM2UINT(timeout);
+}
+
 static VALUE corba_set_connect_timeout(VALUE mod, VALUE duration)
 {
     omniORB::setClientConnectTimeout(NUM2INT(duration));
@@ -97,36 +190,54 @@ static VALUE corba_set_connect_timeout(VALUE mod, VALUE duration)
 
 static void corba_deinit(void*)
 {
+    name_service_watchers_shutdown();
+    clear_interned_task_contexts();
+    delete_embedded_name_service();
     CorbaAccess::deinit();
     rb_iv_set(mCORBA, "@corba", Qnil);
     corbaAccess = Qnil;
 }
 
 /* call-seq:
- *   Runkit::CORBA.do_init => true or false
+ *   Runkit::CORBA.do_init(orb_options) => true or false
  *
  * Initializes the CORBA ORB and gets a reference to the local name server.
  * Returns true if a new connection has been made and false if the CORBA layer
  * was already initialized.
  *
+ * orb_options is an array of command-line options given to the ORB, e.g.
+ * ["-ORBendPoint", "giop:unix:"]
+ *
  * It raises Runkit::CORBAError if either the ORB failed to initialize or the
  * name server cannot be found.
  */
-static VALUE corba_init(VALUE mod)
+static VALUE corba_init(VALUE mod, VALUE orb_options)
 {
     // Initialize only once ...
     if (!NIL_P(corbaAccess))
         return Qfalse;
 
+    std::vector<std::string> args;
+    args.push_back("bla");
+    orb_options = rb_ary_to_ary(orb_options);
+    for (long i = 0; i < RARRAY_LEN(orb_options); ++i) {
+        VALUE arg = rb_ary_entry(orb_options, i);
+        args.push_back(StringValueCStr(arg));
+    }
+
+    std::vector<char*> argv;
+    for (size_t i = 0; i < args.size(); ++i)
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+    argv.push_back(0);
+
     try {
-        char const* argv[2] = {"bla", 0};
-        CorbaAccess::init(1, const_cast<char**>(argv));
+        CorbaAccess::init(args.size(), &argv[0]);
         corbaAccess =
             Data_Wrap_Struct(rb_cObject, 0, corba_deinit, CorbaAccess::instance());
         rb_iv_set(mCORBA, "@corba", corbaAccess);
     }
     catch (CORBA::Exception& e) {
-        rb_raise(eCORBA, "failed to contact the name server");
+        rb_raise(eCORBA, "failed to initialize the ORB: %s", e._name());
     }
     return Qtrue;
 }
@@ -208,6 +319,84 @@ void runkit::corba_must_be_initialized()
             "Corba is not initialized. Call Runkit.initialize first.");
 }
 
+static bool corba_object_non_existent(std::string const& ior)
+{
+    try {
+        CORBA::Object_var obj =
+            RTT::corba::ApplicationServer::orb->string_to_object(ior.c_str());
+        return obj->_non_existent();
+    }
+    catch (CORBA::TRANSIENT&) {
+        return true;
+    }
+    catch (CORBA::COMM_FAILURE&) {
+        return true;
+    }
+    catch (CORBA::OBJECT_NOT_EXIST&) {
+        return true;
+    }
+    catch (CORBA::BAD_PARAM&) {
+        // Invalid IOR
+        return true;
+    }
+}
+
+/** call-seq:
+ *     Runkit::CORBA.do_non_existent?(ior) => true or false
+ *
+ * Checks with a single round trip whether the object the given IOR refers to
+ * is gone. An object that cannot be reached is reported as gone as well
+ */
+static VALUE corba_non_existent_p(VALUE mod, VALUE ior)
+{
+    corba_must_be_initialized();
+
+    bool result = corba_blocking_fct_call_with_result(
+        boost::bind(&corba_object_non_existent, std::string(StringValueCStr(ior))));
+    return result ? Qtrue : Qfalse;
+}
+
+namespace {
+    /** Creates the embedded name service if needed, and returns its address
+     *
+     * It is called without the GVL
+     */
+    std::string start_name_service()
+    {
+        boost::mutex::scoped_lock lock(embedded_name_service_mutex);
+        if (!embedded_name_service)
+            embedded_name_service = new corba::NameService;
+        return embedded_name_service->getIp() + ":" + embedded_name_service->getPort();
+    }
+}
+
+/** call-seq:
+ *     Runkit::CORBA.do_start_name_service => "host:port"
+ *
+ * Serves a name service from this process' ORB, if it is not already done,
+ * and returns the address under which it can be reached
+ */
+static VALUE corba_start_name_service(VALUE mod)
+{
+    corba_must_be_initialized();
+
+    std::string address =
+        corba_blocking_fct_call_with_result(boost::bind(&start_name_service));
+    return rb_str_new(address.c_str(), address.size());
+}
+
+/** call-seq:
+ *     Runkit::CORBA.do_stop_name_service
+ *
+ * Stops the name service started by do_start_name_service. All its bindings
+ * are lost
+ */
+static VALUE corba_stop_name_service(VALUE mod)
+{
+    delete_embedded_name_service();
+    return Qnil;
+}
+
 static VALUE name_service_task_context_names(VALUE self)
 {
     corba_must_be_initialized();
@@ -216,7 +405,7 @@ static VALUE name_service_task_context_names(VALUE self)
     std::vector<std::string> names;
 
     names = corba_blocking_fct_call_with_result(
-        boost::bind(&NameServiceClient::getTaskContextNames, &name_service),
+        boost::bind(&NameServiceClient::getTaskContextNames, &name_service, 10),
         boost::bind(&NameServiceClient::abort, &name_service));
 
     VALUE result = rb_ary_new();
@@ -225,6 +414,37 @@ static VALUE name_service_task_context_names(VALUE self)
     return result;
 }
 
+/** call-seq:
+ *     do_resolve_all(chunk_size, max_threads) => {name => ior}
+ *
+ * Lists the registered task contexts chunk_size bindings at a time, and
+ * resolves them on up to max_threads threads, with the GVL released only
+ * once
+ */
+static VALUE name_service_resolve_all(VALUE self, VALUE chunk_size, VALUE max_threads)
+{
+    corba_must_be_initialized();
+    if (NUM2INT(chunk_size) < 1)
+        rb_raise(rb_eArgError, "chunk_size must be at least 1");
+    if (NUM2INT(max_threads) < 1)
+        rb_raise(rb_eArgError, "max_threads must be at least 1");
+
+    NameServiceClient& name_service = get_wrapped<NameServiceClient>(self);
+    std::map<std::string, std::string> iors;
+    iors = corba_blocking_fct_call_with_result(boost::bind(&NameServiceClient::resolveAll,
+                                                   &name_service,
+                                                   NUM2UINT(chunk_size),
+                                                   NUM2UINT(max_threads)),
+        boost::bind(&NameServiceClient::abort, &name_service));
+
+    VALUE result = rb_hash_new();
+    for (std::map<std::string, std::string>::const_iterator it = iors.begin();
+         it != iors.end();
+         ++it)
+        rb_hash_aset(result, rb_str_new2(it->first.c_str()), rb_str_new2(it->second.c_str()));
+    return result;
+}
+
 static VALUE name_service_unbind(VALUE self, VALUE task_name)
 {
     corba_must_be_initialized();
@@ -276,8 +496,32 @@ void runkit::rtt_corba_init_CORBA(VALUE mRoot, VALUE mCORBA, VALUE mNameServices
         "initialized?",
         RUBY_METHOD_FUNC(corba_is_initialized),
         0);
-    rb_define_singleton_method(mCORBA, "do_initialize", RUBY_METHOD_FUNC(corba_init), 0);
+    rb_define_singleton_method(mCORBA, "do_initialize", RUBY_METHOD_FUNC(corba_init), 1);
     rb_define_singleton_method(mCORBA, "do_clear", RUBY_METHOD_FUNC(corba_deinit), 0);
+    rb_define_singleton_method(mCORBA,
+        "do_non_existent?",
+        RUBY_METHOD_FUNC(corba_non_existent_p),
+        1);
+    rb_define_singleton_method(mCORBA,
+        "do_start_name_service",
+        RUBY_METHOD_FUNC(corba_start_name_service),
+        0);
+    rb_define_singleton_method(mCORBA,
+        "do_stop_name_service",
+        RUBY_METHOD_FUNC(corba_stop_name_service),
+        0);
+    rb_define_singleton_method(mCORBA,
+        "collocation=",
+        RUBY_METHOD_FUNC(corba_set_collocation),
+        1);
+    rb_define_singleton_method(mCORBA,
+        "collocation?",
+        RUBY_METHOD_FUNC(corba_collocation_p),
+        0);
+    rb_define_singleton_method(mCORBA,
+        "collocated_call_count",
+        RUBY_METHOD_FUNC(corba_collocated_call_count),
+        0);
     rb_define_singleton_method(mCORBA,
         "do_call_timeout",
         RUBY_METHOD_FUNC(corba_set_call_timeout),
@@ -302,6 +546,10 @@ void runkit::rtt_corba_init_CORBA(VALUE mRoot, VALUE mCORBA, VALUE mNameServices
         RUBY_METHOD_FUNC(name_service_task_context_names),
         0);
     rb_define_method(cNameService, "do_ior", RUBY_METHOD_FUNC(name_service_ior), 1);
+    rb_define_method(cNameService,
+        "do_resolve_all",
+        RUBY_METHOD_FUNC(name_service_resolve_all),
+        2);
     rb_define_method(cNameService, "do_ip", RUBY_METHOD_FUNC(name_service_ip), 0);
     rb_define_method(cNameService, "do_port", RUBY_METHOD_FUNC(name_service_port), 0);
     rb_define_method(cNameService,
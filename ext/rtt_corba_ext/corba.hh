@@ -3,12 +3,16 @@
 
 #include <omniORB4/CORBA.h>
 
+#include <boost/shared_ptr.hpp>
 #include <exception>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "DataFlowC.h"
 #include "StdExceptionC.h"
 #include "TaskContextC.h"
+#include "call_timeout.hh"
 #include "rblocking_call.h"
 
 #include <typelib/value.hh>
@@ -100,11 +104,102 @@ namespace runkit {
     extern VALUE eNotFound;
     extern VALUE eNotInitialized;
 
+    /** Signature of an operation, as needed to call it from Ruby */
+    struct OperationSignature {
+        struct Argument {
+            std::string name;
+            std::string description;
+            std::string type;
+        };
+
+        /** Whether the result type and arguments are known */
+        bool has_description;
+        /** Whether the collect types are known as well */
+        bool complete;
+        /** The result type followed by the types of the collected arguments */
+        std::vector<std::string> return_types;
+        std::vector<Argument> arguments;
+
+        OperationSignature()
+            : has_description(false)
+            , complete(false)
+        {
+        }
+    };
+
+    /** A task context that lives in this process, i.e. a Ruby task
+     *
+     * The task pointer is reset when the task is disposed of. It is only
+     * accessed with the GVL held
+     */
+    struct CollocatedTask {
+        RTT::TaskContext* task;
+    };
+    typedef boost::shared_ptr<CollocatedTask> CollocatedTaskPtr;
+
+    /** Registers a task context of this process under its IOR, so that the
+     * RTaskContext objects created for this IOR can call it directly
+     */
+    void register_collocated_task(std::string const& ior, RTT::TaskContext* task);
+    /** Removes a task registered with register_collocated_task. The
+     * RTaskContext objects that refer to it fall back to CORBA
+     */
+    void unregister_collocated_task(RTT::TaskContext* task);
+    /** Returns the collocated task registered under this IOR, or a null
+     * pointer if there is none or if collocation is disabled
+     */
+    CollocatedTaskPtr find_collocated_task(std::string const& ior);
+
+    /** Number of times RTaskContext::collocatedTask returned a task, i.e.
+     * a call considered the direct path. It is meant for the tests
+     */
+    extern size_t collocated_call_count;
+
     struct RTaskContext {
         RTT::corba::CTaskContext_var task;
         RTT::corba::CService_var main_service;
         RTT::corba::CDataFlowInterface_var ports;
         std::string name;
+
+        /** Cache of the signatures of the task's operations
+         *
+         * It is only accessed with the GVL held
+         */
+        std::map<std::string, OperationSignature> operation_signatures;
+
+        /** Set if the task lives in this process */
+        CollocatedTaskPtr collocated;
+
+        /** Number of Ruby objects that wrap this object
+         *
+         * The Ruby task contexts created for the same IOR share the same
+         * RTaskContext, which is deleted when the last of them is garbage
+         * collected. It is only accessed with the GVL held
+         */
+        size_t ruby_refs;
+        /** The IOR under which this object is interned, or an empty string if
+         * it is not interned (anymore)
+         */
+        std::string interned_ior;
+
+        RTaskContext()
+            : ruby_refs(0)
+        {
+        }
+
+        /** Returns the task context if it lives in this process and has not
+         * been disposed of, and NULL otherwise
+         *
+         * The calls that have a direct path use it to bypass CORBA. It must
+         * only be used with the GVL held
+         */
+        RTT::TaskContext* collocatedTask() const
+        {
+            RTT::TaskContext* task = collocated ? collocated->task : 0;
+            if (task)
+                ++collocated_call_count;
+            return task;
+        }
     };
 
     /**
@@ -153,6 +248,14 @@ namespace runkit {
         }
     };
 
+    /** Returns the timeout set on the current Ruby thread by
+     * Runkit::CORBA.with_call_timeout, in milliseconds, or zero if there is
+     * none
+     *
+     * Must be called with the GVL held
+     */
+    CORBA::ULong current_call_timeout();
+
     template <typename F, typename A = boost::function<void()>>
     class CORBABlockingFunction : public BlockingFunction<F, A> {
     public:
@@ -164,8 +267,17 @@ namespace runkit {
                 abort);
         }
 
+        template <typename E> static void call(F processing, A abort, E on_error)
+        {
+            return BlockingFunctionBase::doCall<void, CORBABlockingFunction<F, A>>(
+                processing,
+                abort,
+                on_error);
+        }
+
         CORBABlockingFunction(F processing, A abort)
             : BlockingFunction<F, A>(processing, abort)
+            , call_timeout(current_call_timeout())
         {
         }
 
@@ -173,11 +285,15 @@ namespace runkit {
         {
             // add corba exception handlers
             try {
+                ThreadCallTimeout timeout(call_timeout);
                 this->processing_fct();
             }
             CORBA_EXCEPTION_HANDLERS
             EXCEPTION_HANDLERS
         }
+
+    private:
+        CORBA::ULong call_timeout;
     };
 
     template <typename F, typename A = boost::function<void()>>
@@ -191,9 +307,17 @@ namespace runkit {
                 CORBABlockingFunctionWithResult<F, A>>(processing, abort);
         }
 
+        template <typename E>
+        static result_t call(F processing, A abort, E on_error)
+        {
+            return BlockingFunctionBase::doCall<result_t,
+                CORBABlockingFunctionWithResult<F, A>>(processing, abort, on_error);
+        }
+
         CORBABlockingFunctionWithResult(F processing, A abort)
             : BlockingFunctionWithResult<F, A>::BlockingFunctionWithResult(processing,
                   abort)
+            , call_timeout(current_call_timeout())
         {
         }
 
@@ -201,11 +325,15 @@ namespace runkit {
         {
             // add corba exception handlers
             try {
+                ThreadCallTimeout timeout(call_timeout);
                 this->return_val = this->processing_fct();
             }
             CORBA_EXCEPTION_HANDLERS
             EXCEPTION_HANDLERS
         }
+
+    private:
+        CORBA::ULong call_timeout;
     };
 
     // template functions can automatically pick up their template paramters
@@ -230,6 +358,47 @@ namespace runkit {
     {
         return CORBABlockingFunctionWithResult<F>::call(processing);
     }
+
+    /** Removes a task context from the table of task contexts indexed by IOR,
+     * so that the next TaskContext.new for its IOR resolves it again
+     *
+     * Must be called with the GVL held
+     */
+    void forget_interned_task_context(RTaskContext* context);
+
+    /** Clears the table of task contexts indexed by IOR */
+    void clear_interned_task_contexts();
+
+    /** Called when a call on a task failed. Communication errors remove the
+     * task from the table of task contexts indexed by IOR
+     */
+    void task_call_failed(RTaskContext* context, VALUE exception_class);
+
+    /** Like corba_blocking_fct_call, for a call on the given task
+     *
+     * If the call fails with a communication error, the task is removed from
+     * the table of task contexts indexed by IOR
+     */
+    template <typename F> void task_blocking_fct_call(RTaskContext& task, F processing)
+    {
+        CORBABlockingFunction<F>::call(processing,
+            boost::bind(&BlockingFunctionBase::abort_default),
+            boost::bind(&task_call_failed, &task, _1));
+    }
+
+    /** Like corba_blocking_fct_call_with_result, for a call on the given task
+     *
+     * If the call fails with a communication error, the task is removed from
+     * the table of task contexts indexed by IOR
+     */
+    template <typename F>
+    typename F::result_type task_blocking_fct_call_with_result(RTaskContext& task,
+        F processing)
+    {
+        return CORBABlockingFunctionWithResult<F>::call(processing,
+            boost::bind(&BlockingFunctionBase::abort_default),
+            boost::bind(&task_call_failed, &task, _1));
+    }
 }
 
 #endif
@@ -1,7 +1,10 @@
 #include "rtt-corba.hh"
 
+#include "async_call.hh"
 #include "corba.hh"
 #include "datahandling.hh"
+#include "handle_pool.hh"
+#include <rtt/TaskContext.hpp>
 #include <rtt/base/PortInterface.hpp>
 #include <rtt/transports/corba/CorbaLib.hpp>
 #include <rtt/types/TypeTransporter.hpp>
@@ -39,20 +42,18 @@ VALUE runkit::corba_to_ruby(std::string const& type_name,
             rb_raise(eCORBA, "failed to unmarshal %s", type_name.c_str());
     }
     else {
-        orogen_transports::TypelibMarshallerBase::Handle* handle =
-            typelib_transport->createHandle();
-        // Set the typelib sample but don't copy it to the typelib sample as we
-        // will copy back anyway
+        HandlePool& pool = HandlePool::forType(ti, typelib_transport);
+        HandlePool::Entry entry = pool.acquire();
+        orogen_transports::TypelibMarshallerBase::Handle* handle = entry.handle;
+        // Make dest the typelib sample, so that the conversion from the
+        // orocos sample writes into it directly
         typelib_transport->setTypelibSample(handle, dest, false);
-        RTT::base::DataSourceBase::shared_ptr ds =
-            typelib_transport->getDataSource(handle);
-        if (!corba_transport->updateFromAny(&src, ds))
+        if (!corba_transport->updateFromAny(&src, entry.data_source)) {
+            pool.release(entry);
             rb_raise(eCORBA, "failed to unmarshal %s", type_name.c_str());
-        typelib_transport->refreshTypelibSample(handle);
-
-        Typelib::copy(dest,
-            Typelib::Value(typelib_transport->getTypelibSample(handle), dest.getType()));
-        typelib_transport->deleteHandle(handle);
+        }
+        pool.refreshTypelibSample(entry, dest);
+        pool.release(entry);
     }
 
     return Qnil;
@@ -78,29 +79,116 @@ CORBA::Any* runkit::ruby_to_corba(std::string const& type_name, Typelib::Value s
             rb_raise(eCORBA, "failed to marshal %s", type_name.c_str());
     }
     else {
-        orogen_transports::TypelibMarshallerBase::Handle* handle =
-            typelib_transport->createHandle();
+        HandlePool& pool = HandlePool::forType(ti, typelib_transport);
+        HandlePool::Entry entry = pool.acquire();
         try {
-            typelib_transport->setTypelibSample(handle, src);
+            typelib_transport->setTypelibSample(entry.handle, src);
         }
         catch (std::exception& e) {
+            pool.release(entry);
             rb_raise(eCORBA, "failed to marshal %s: %s", type_name.c_str(), e.what());
         }
 
-        RTT::base::DataSourceBase::shared_ptr ds =
-            typelib_transport->getDataSource(handle);
-        result = corba_transport->createAny(ds);
-        typelib_transport->deleteHandle(handle);
+        result = corba_transport->createAny(entry.data_source);
+        pool.release(entry);
     }
 
     return result;
 }
 
+namespace {
+    /** Returns the data source of a property of a task that lives in this
+     * process, or a null pointer if the task is remote or if it has no such
+     * property (in which case the CORBA path reports the error)
+     */
+    DataSourceBase::shared_ptr collocated_property(RTaskContext& task, VALUE name)
+    {
+        RTT::TaskContext* local = task.collocatedTask();
+        if (!local)
+            return DataSourceBase::shared_ptr();
+        PropertyBase* property = local->properties()->getProperty(StringValuePtr(name));
+        if (!property)
+            return DataSourceBase::shared_ptr();
+        return property->getDataSource();
+    }
+
+    /** Attribute counterpart of collocated_property */
+    DataSourceBase::shared_ptr collocated_attribute(RTaskContext& task, VALUE name)
+    {
+        RTT::TaskContext* local = task.collocatedTask();
+        if (!local)
+            return DataSourceBase::shared_ptr();
+        AttributeBase* attribute = local->provides()->getAttribute(StringValuePtr(name));
+        if (!attribute)
+            return DataSourceBase::shared_ptr();
+        return attribute->getDataSource();
+    }
+
+    /** Copies the value of a data source of this process into +dest+, without
+     * going through a CORBA::Any
+     */
+    void local_to_ruby(std::string const& type_name,
+        Typelib::Value dest,
+        DataSourceBase::shared_ptr src)
+    {
+        TypeInfo* ti = get_type_info(type_name);
+        orogen_transports::TypelibMarshallerBase* typelib_transport =
+            get_typelib_transport(ti, false);
+
+        if (!typelib_transport || typelib_transport->isPlainTypelibType()) {
+            DataSourceBase::shared_ptr ds = ti->buildReference(dest.getData());
+            if (!ds->update(src.get()))
+                rb_raise(rb_eArgError, "failed to read %s", type_name.c_str());
+            return;
+        }
+
+        HandlePool& pool = HandlePool::forType(ti, typelib_transport);
+        HandlePool::Entry entry = pool.acquire();
+        typelib_transport->setTypelibSample(entry.handle, dest, false);
+        if (!entry.data_source->update(src.get())) {
+            pool.release(entry);
+            rb_raise(rb_eArgError, "failed to read %s", type_name.c_str());
+        }
+        pool.refreshTypelibSample(entry, dest);
+        pool.release(entry);
+    }
+
+    /** Copies +src+ into a data source of this process, without going
+     * through a CORBA::Any
+     */
+    bool ruby_to_local(std::string const& type_name,
+        Typelib::Value src,
+        DataSourceBase::shared_ptr dest)
+    {
+        TypeInfo* ti = get_type_info(type_name);
+        orogen_transports::TypelibMarshallerBase* typelib_transport =
+            get_typelib_transport(ti, false);
+
+        if (!typelib_transport || typelib_transport->isPlainTypelibType()) {
+            DataSourceBase::shared_ptr ds = ti->buildReference(src.getData());
+            return dest->update(ds.get());
+        }
+
+        HandlePool& pool = HandlePool::forType(ti, typelib_transport);
+        HandlePool::Entry entry = pool.acquire();
+        try {
+            typelib_transport->setTypelibSample(entry.handle, src);
+        }
+        catch (std::exception& e) {
+            pool.release(entry);
+            rb_raise(eCORBA, "failed to marshal %s: %s", type_name.c_str(), e.what());
+        }
+        bool result = dest->update(entry.data_source.get());
+        pool.release(entry);
+        return result;
+    }
+}
+
 static VALUE property_do_read_string(VALUE rbtask, VALUE property_name)
 {
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
 
-    CORBA::Any_var corba_value = corba_blocking_fct_call_with_result(
+    CORBA::Any_var corba_value = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::getProperty,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name)));
@@ -119,7 +207,12 @@ static VALUE property_do_read(VALUE rbtask,
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
     Typelib::Value value = typelib_get(rb_typelib_value);
 
-    CORBA::Any_var corba_value = corba_blocking_fct_call_with_result(
+    if (DataSourceBase::shared_ptr local = collocated_property(task, property_name)) {
+        local_to_ruby(StringValuePtr(type_name), value, local);
+        return rb_typelib_value;
+    }
+
+    CORBA::Any_var corba_value = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::getProperty,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name)));
@@ -127,13 +220,71 @@ static VALUE property_do_read(VALUE rbtask,
     return rb_typelib_value;
 }
 
+namespace {
+    struct PropertyReadCall : public AsyncCall {
+        RTT::corba::CService_var service;
+        std::string property_name;
+        std::string type_name;
+        VALUE rb_typelib_value;
+        CORBA::Any_var corba_value;
+
+        PropertyReadCall(RTT::corba::CService_ptr service,
+            std::string const& property_name,
+            std::string const& type_name,
+            VALUE rb_typelib_value)
+            : service(RTT::corba::CService::_duplicate(service))
+            , property_name(property_name)
+            , type_name(type_name)
+            , rb_typelib_value(rb_typelib_value)
+        {
+        }
+
+        void run()
+        {
+            corba_value = service->getProperty(property_name.c_str());
+        }
+
+        VALUE toRuby()
+        {
+            Typelib::Value value = typelib_get(rb_typelib_value);
+            corba_to_ruby(type_name, value, corba_value.inout());
+            return rb_typelib_value;
+        }
+
+        void mark()
+        {
+            rb_gc_mark(rb_typelib_value);
+        }
+    };
+}
+
+/** call-seq:
+ *     do_property_read_async(name, type_name, typelib_value) => async_call
+ *
+ * Asynchronous version of #do_property_read. The returned Runkit::AsyncCall's
+ * value is typelib_value, updated with the property's value
+ */
+static VALUE property_do_read_async(VALUE rbtask,
+    VALUE property_name,
+    VALUE type_name,
+    VALUE rb_typelib_value)
+{
+    RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
+    boost::shared_ptr<AsyncCall> call(new PropertyReadCall(task.main_service.in(),
+        StringValuePtr(property_name),
+        StringValuePtr(type_name),
+        rb_typelib_value));
+    call->setTask(rbtask);
+    return async_call_start(call);
+}
+
 static VALUE property_do_write_string(VALUE rbtask, VALUE property_name, VALUE rb_value)
 {
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
 
     CORBA::Any_var corba_value = new CORBA::Any;
     corba_value <<= StringValuePtr(rb_value);
-    bool result = corba_blocking_fct_call_with_result(
+    bool result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::setProperty,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name),
@@ -151,8 +302,14 @@ static VALUE property_do_write(VALUE rbtask,
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
     Typelib::Value value = typelib_get(rb_typelib_value);
 
+    if (DataSourceBase::shared_ptr local = collocated_property(task, property_name)) {
+        if (!ruby_to_local(StringValuePtr(type_name), value, local))
+            rb_raise(rb_eArgError, "failed to write the property");
+        return Qnil;
+    }
+
     CORBA::Any_var corba_value = ruby_to_corba(StringValuePtr(type_name), value);
-    bool result = corba_blocking_fct_call_with_result(
+    bool result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::setProperty,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name),
@@ -162,11 +319,185 @@ static VALUE property_do_write(VALUE rbtask,
     return Qnil;
 }
 
+/** Maximum number of threads the bulk property accessors use
+ *
+ * It is an upper bound, clamped to Runkit::CORBA.async_worker_count + 1 (see
+ * ParallelCalls)
+ */
+static const size_t MAX_PROPERTY_THREADS = 8;
+
+namespace {
+    struct PropertyWriteCall : public AsyncCall {
+        RTT::corba::CService_var service;
+        std::string property_name;
+        CORBA::Any_var corba_value;
+        bool marshalled;
+        bool result;
+
+        /** corba_value may be null if the value could not be marshalled. The
+         * call then does nothing, and its error must be set by the caller
+         */
+        PropertyWriteCall(RTT::corba::CService_ptr service,
+            std::string const& property_name,
+            CORBA::Any* corba_value)
+            : service(RTT::corba::CService::_duplicate(service))
+            , property_name(property_name)
+            , corba_value(corba_value)
+            , marshalled(corba_value != 0)
+            , result(false)
+        {
+        }
+
+        void run()
+        {
+            if (!marshalled)
+                return;
+            result = service->setProperty(property_name.c_str(), corba_value.in());
+        }
+
+        VALUE toRuby()
+        {
+            return result ? Qtrue : Qfalse;
+        }
+    };
+
+    /** Validates the arguments of the bulk property accessors
+     *
+     * It raises on the arguments that would make the accessors raise later,
+     * and must therefore be called before any C++ object gets created
+     */
+    void check_bulk_arguments(VALUE names, VALUE type_names, VALUE values)
+    {
+        Check_Type(names, T_ARRAY);
+        Check_Type(type_names, T_ARRAY);
+        Check_Type(values, T_ARRAY);
+        if (RARRAY_LEN(names) != RARRAY_LEN(type_names) ||
+            RARRAY_LEN(names) != RARRAY_LEN(values))
+            rb_raise(rb_eArgError,
+                "expected the same number of names, type names and values");
+
+        for (long i = 0; i < RARRAY_LEN(names); ++i) {
+            VALUE name = rb_ary_entry(names, i);
+            VALUE type_name = rb_ary_entry(type_names, i);
+            StringValuePtr(name);
+            StringValuePtr(type_name);
+            typelib_get(rb_ary_entry(values, i));
+        }
+    }
+
+    struct PropertyMarshalling {
+        std::string type_name;
+        Typelib::Value value;
+        CORBA::Any* result;
+    };
+
+    VALUE protected_ruby_to_corba(VALUE arg)
+    {
+        PropertyMarshalling& marshalling = *reinterpret_cast<PropertyMarshalling*>(arg);
+        marshalling.result = ruby_to_corba(marshalling.type_name, marshalling.value);
+        return Qnil;
+    }
+}
+
+/** call-seq:
+ *     do_properties_read(names, type_names, typelib_values) => results
+ *
+ * Reads many properties with the GVL released only once. The calls are made
+ * in parallel.
+ *
+ * Returns an array with, for each property, either its typelib value updated
+ * with the property's value or the exception raised while reading it
+ */
+static VALUE properties_do_read(VALUE rbtask,
+    VALUE property_names,
+    VALUE type_names,
+    VALUE rb_typelib_values)
+{
+    check_bulk_arguments(property_names, type_names, rb_typelib_values);
+    RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
+
+    long count = RARRAY_LEN(property_names);
+    AsyncCalls calls;
+    calls.reserve(count);
+    for (long i = 0; i < count; ++i) {
+        VALUE name = rb_ary_entry(property_names, i);
+        VALUE type_name = rb_ary_entry(type_names, i);
+        calls.push_back(boost::shared_ptr<AsyncCall>(
+            new PropertyReadCall(task.main_service.in(),
+                StringValuePtr(name),
+                StringValuePtr(type_name),
+                rb_ary_entry(rb_typelib_values, i))));
+        calls.back()->setTask(rbtask);
+    }
+    return async_calls_execute(calls, MAX_PROPERTY_THREADS);
+}
+
+/** call-seq:
+ *     do_properties_write(names, type_names, typelib_values) => results
+ *
+ * Writes many properties with the GVL released only once. All the values are
+ * marshalled before the calls are made in parallel. A value that cannot be
+ * marshalled is reported as the result of its property, and not written.
+ *
+ * Returns an array with, for each property, either true, false if the
+ * remote task rejected the value, or the exception raised while writing it
+ */
+static VALUE properties_do_write(VALUE rbtask,
+    VALUE property_names,
+    VALUE type_names,
+    VALUE rb_typelib_values)
+{
+    check_bulk_arguments(property_names, type_names, rb_typelib_values);
+    RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
+
+    long count = RARRAY_LEN(property_names);
+    AsyncCalls calls;
+    calls.reserve(count);
+    int fatal_state = 0;
+    for (long i = 0; i < count && !fatal_state; ++i) {
+        VALUE name = rb_ary_entry(property_names, i);
+        VALUE type_name = rb_ary_entry(type_names, i);
+        PropertyMarshalling marshalling;
+        marshalling.type_name = StringValuePtr(type_name);
+        marshalling.value = typelib_get(rb_ary_entry(rb_typelib_values, i));
+        marshalling.result = 0;
+
+        // ruby_to_corba raises on errors. Catch them so that they do not
+        // skip the destruction of the calls, and report them as the result of
+        // the property's write
+        int state = 0;
+        rb_protect(&protected_ruby_to_corba,
+            reinterpret_cast<VALUE>(&marshalling),
+            &state);
+        calls.push_back(boost::shared_ptr<AsyncCall>(new PropertyWriteCall(
+            task.main_service.in(), StringValuePtr(name), marshalling.result)));
+        calls.back()->setTask(rbtask);
+        if (state) {
+            VALUE error = rb_errinfo();
+            if (!rb_obj_is_kind_of(error, rb_eStandardError)) {
+                // Not an error of the conversion (e.g. the thread is being
+                // killed), re-raise it once the calls are deleted
+                fatal_state = state;
+                continue;
+            }
+            rb_set_errinfo(Qnil);
+            VALUE message = rb_obj_as_string(error);
+            calls.back()->rb_raise(rb_obj_class(error),
+                std::string(RSTRING_PTR(message), RSTRING_LEN(message)));
+        }
+    }
+    if (fatal_state) {
+        AsyncCalls().swap(calls);
+        rb_jump_tag(fatal_state);
+    }
+    return async_calls_execute(calls, MAX_PROPERTY_THREADS);
+}
+
 static VALUE attribute_do_read_string(VALUE rbtask, VALUE property_name)
 {
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
 
-    CORBA::Any_var corba_value = corba_blocking_fct_call_with_result(
+    CORBA::Any_var corba_value = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::getAttribute,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name)));
@@ -185,7 +516,12 @@ static VALUE attribute_do_read(VALUE rbtask,
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
     Typelib::Value value = typelib_get(rb_typelib_value);
 
-    CORBA::Any_var corba_value = corba_blocking_fct_call_with_result(
+    if (DataSourceBase::shared_ptr local = collocated_attribute(task, property_name)) {
+        local_to_ruby(StringValuePtr(type_name), value, local);
+        return rb_typelib_value;
+    }
+
+    CORBA::Any_var corba_value = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::getAttribute,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name)));
@@ -199,7 +535,7 @@ static VALUE attribute_do_write_string(VALUE rbtask, VALUE property_name, VALUE
 
     CORBA::Any_var corba_value = new CORBA::Any;
     corba_value <<= StringValuePtr(rb_value);
-    bool result = corba_blocking_fct_call_with_result(
+    bool result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::setAttribute,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name),
@@ -217,8 +553,14 @@ static VALUE attribute_do_write(VALUE rbtask,
     RTaskContext& task = get_wrapped<RTaskContext>(rbtask);
     Typelib::Value value = typelib_get(rb_typelib_value);
 
+    if (DataSourceBase::shared_ptr local = collocated_attribute(task, property_name)) {
+        if (!ruby_to_local(StringValuePtr(type_name), value, local))
+            rb_raise(rb_eArgError, "failed to write the attribute");
+        return Qnil;
+    }
+
     CORBA::Any_var corba_value = ruby_to_corba(StringValuePtr(type_name), value);
-    bool result = corba_blocking_fct_call_with_result(
+    bool result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_CConfigurationInterface::setAttribute,
             (_objref_CConfigurationInterface*)task.main_service,
             StringValuePtr(property_name),
@@ -242,10 +584,22 @@ void runkit::rtt_corba_init_data_handling(VALUE cTaskContext)
         "do_property_read",
         RUBY_METHOD_FUNC(property_do_read),
         3);
+    rb_define_method(cTaskContext,
+        "do_property_read_async",
+        RUBY_METHOD_FUNC(property_do_read_async),
+        3);
     rb_define_method(cTaskContext,
         "do_property_write",
         RUBY_METHOD_FUNC(property_do_write),
         3);
+    rb_define_method(cTaskContext,
+        "do_properties_read",
+        RUBY_METHOD_FUNC(properties_do_read),
+        3);
+    rb_define_method(cTaskContext,
+        "do_properties_write",
+        RUBY_METHOD_FUNC(properties_do_write),
+        3);
     rb_define_method(cTaskContext,
         "do_attribute_read_string",
         RUBY_METHOD_FUNC(attribute_do_read_string),
@@ -0,0 +1,145 @@
+#include "handle_pool.hh"
+#include "rtt-corba.hh"
+
+#include <map>
+#include <rtt/types/TypeInfo.hpp>
+#include <typelib/value_ops.hh>
+
+using namespace runkit;
+
+typedef std::map<orogen_transports::TypelibMarshallerBase*, HandlePool*> HandlePools;
+static HandlePools handle_pools;
+static boost::mutex handle_pools_mutex;
+
+HandlePool::HandlePool(std::string const& type_name,
+    orogen_transports::TypelibMarshallerBase* transport)
+    : type_name(type_name)
+    , transport(transport)
+    , hits(0)
+    , misses(0)
+    , copies(0)
+{
+}
+
+HandlePool::~HandlePool()
+{
+    for (size_t i = 0; i < free_entries.size(); ++i)
+        transport->deleteHandle(free_entries[i].handle);
+}
+
+HandlePool& HandlePool::forType(RTT::types::TypeInfo* type,
+    orogen_transports::TypelibMarshallerBase* transport)
+{
+    boost::mutex::scoped_lock lock(handle_pools_mutex);
+    HandlePool*& pool = handle_pools[transport];
+    if (!pool)
+        pool = new HandlePool(type->getTypeName(), transport);
+    return *pool;
+}
+
+HandlePool::Entry HandlePool::acquire()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        if (!free_entries.empty()) {
+            Entry entry = free_entries.back();
+            free_entries.pop_back();
+            ++hits;
+            return entry;
+        }
+        ++misses;
+    }
+
+    Entry entry;
+    entry.handle = transport->createHandle();
+    entry.data_source = transport->getDataSource(entry.handle);
+    return entry;
+}
+
+void HandlePool::release(Entry const& entry)
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        if (free_entries.size() < MAX_FREE_HANDLES) {
+            free_entries.push_back(entry);
+            return;
+        }
+    }
+    transport->deleteHandle(entry.handle);
+}
+
+void HandlePool::refreshTypelibSample(Entry const& entry, Typelib::Value dest)
+{
+    transport->refreshTypelibSample(entry.handle);
+    void* sample = transport->getTypelibSample(entry.handle);
+    if (sample == dest.getData())
+        return;
+
+    Typelib::copy(dest, Typelib::Value(sample, dest.getType()));
+    boost::mutex::scoped_lock lock(mutex);
+    ++copies;
+}
+
+HandlePool::Stats HandlePool::getStats()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    Stats stats = {hits, misses, free_entries.size(), copies};
+    return stats;
+}
+
+void HandlePool::resetStats()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    hits = 0;
+    misses = 0;
+    copies = 0;
+}
+
+/** call-seq:
+ *     Runkit.handle_pool_stats => {type_name => {hits:, misses:, free:, copies:}}
+ *
+ * Returns usage statistics of the pools of marshalling handles used to convert
+ * opaque types. In steady state, the number of misses (i.e. of allocated
+ * handles) should not increase anymore. +copies+ counts the samples that had
+ * to be copied after conversion instead of being converted in place.
+ */
+static VALUE handle_pool_stats(VALUE mod)
+{
+    VALUE result = rb_hash_new();
+    boost::mutex::scoped_lock lock(handle_pools_mutex);
+    for (HandlePools::const_iterator it = handle_pools.begin();
+         it != handle_pools.end();
+         ++it) {
+        HandlePool::Stats stats = it->second->getStats();
+        VALUE entry = rb_hash_new();
+        rb_hash_aset(entry, ID2SYM(rb_intern("hits")), SIZET2NUM(stats.hits));
+        rb_hash_aset(entry, ID2SYM(rb_intern("misses")), SIZET2NUM(stats.misses));
+        rb_hash_aset(entry, ID2SYM(rb_intern("free")), SIZET2NUM(stats.free));
+        rb_hash_aset(entry, ID2SYM(rb_intern("copies")), SIZET2NUM(stats.copies));
+        rb_hash_aset(result, rb_str_new2(it->second->getTypeName().c_str()), entry);
+    }
+    return result;
+}
+
+static VALUE handle_pool_reset_stats(VALUE mod)
+{
+    boost::mutex::scoped_lock lock(handle_pools_mutex);
+    for (HandlePools::const_iterator it = handle_pools.begin();
+         it != handle_pools.end();
+         ++it) {
+        it->second->resetStats();
+    }
+    return Qnil;
+}
+
+void runkit::rtt_corba_init_handle_pool(VALUE mRoot)
+{
+    rb_define_singleton_method(mRoot,
+        "handle_pool_stats",
+        RUBY_METHOD_FUNC(handle_pool_stats),
+        0);
+    rb_define_singleton_method(mRoot,
+        "reset_handle_pool_stats",
+        RUBY_METHOD_FUNC(handle_pool_reset_stats),
+        0);
+}
@@ -0,0 +1,95 @@
+#ifndef RUNKIT_CORBA_EXT_HANDLE_POOL_HH
+#define RUNKIT_CORBA_EXT_HANDLE_POOL_HH
+
+#include <boost/thread/mutex.hpp>
+#include <rtt/base/DataSourceBase.hpp>
+#include <rtt/typelib/TypelibMarshallerBase.hpp>
+#include <typelib/value.hh>
+
+#include <string>
+#include <vector>
+
+namespace RTT {
+    namespace types {
+        class TypeInfo;
+    }
+}
+
+namespace runkit {
+    /** Pool of marshalling handles for a given (opaque) type
+     *
+     * Creating a handle allocates an orocos sample and the data source that
+     * refers to it. This pool allows to reuse them across calls instead of
+     * creating and deleting them for every sample.
+     *
+     * It must only be used for non-plain types, as handles of plain types do
+     * not own a stable orocos sample.
+     */
+    class HandlePool {
+    public:
+        struct Entry {
+            orogen_transports::TypelibMarshallerBase::Handle* handle;
+            RTT::base::DataSourceBase::shared_ptr data_source;
+        };
+
+        struct Stats {
+            size_t hits;
+            size_t misses;
+            size_t free;
+            size_t copies;
+        };
+
+        /** Maximum number of unused handles kept in a pool
+         *
+         * Handles released while the pool is full are deleted
+         */
+        static const size_t MAX_FREE_HANDLES = 16;
+
+        HandlePool(std::string const& type_name,
+            orogen_transports::TypelibMarshallerBase* transport);
+        ~HandlePool();
+
+        /** Returns the pool associated with the given type's transport
+         *
+         * Pools are created on demand and live until the end of the process
+         */
+        static HandlePool& forType(RTT::types::TypeInfo* type,
+            orogen_transports::TypelibMarshallerBase* transport);
+
+        /** Get a handle from the pool, creating it if needed */
+        Entry acquire();
+        /** Give back a handle acquired with acquire() */
+        void release(Entry const& entry);
+
+        /** Converts the orocos sample of a handle into +dest+
+         *
+         * Readers set the handle's typelib sample to +dest+ with
+         * setTypelibSample beforehand, in which case the conversion writes
+         * into +dest+ directly. The converted sample is copied into +dest+
+         * only if the transport used a buffer of its own.
+         */
+        void refreshTypelibSample(Entry const& entry, Typelib::Value dest);
+
+        std::string const& getTypeName() const
+        {
+            return type_name;
+        }
+        orogen_transports::TypelibMarshallerBase* getTransport() const
+        {
+            return transport;
+        }
+        Stats getStats();
+        void resetStats();
+
+    private:
+        std::string type_name;
+        orogen_transports::TypelibMarshallerBase* transport;
+        std::vector<Entry> free_entries;
+        boost::mutex mutex;
+        size_t hits;
+        size_t misses;
+        size_t copies;
+    };
+}
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ In-process CORBA name service
+ */
+
+#include "corba_name_service.hh"
+#include "corba_name_service_client.hh"
+#include <omniORB4/omniIOR.h>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+using namespace corba;
+
+namespace
+{
+    // Servant of the iterators returned by NamingContextImpl::list
+    class BindingIteratorImpl : public POA_CosNaming::BindingIterator
+    {
+        public:
+            BindingIteratorImpl(PortableServer::POA_ptr poa, CosNaming::BindingList const& list, CORBA::ULong position):
+                poa(PortableServer::POA::_duplicate(poa)),
+                list(list),
+                position(position)
+            {
+            }
+
+            PortableServer::POA_ptr _default_POA()
+            {
+                return PortableServer::POA::_duplicate(poa);
+            }
+
+            CORBA::Boolean next_one(CosNaming::Binding_out b)
+            {
+                boost::mutex::scoped_lock lock(mut);
+                b = new CosNaming::Binding;
+                if (position >= list.length())
+                {
+                    b->binding_type = CosNaming::nobject;
+                    return false;
+                }
+                *b.ptr() = list[position++];
+                return true;
+            }
+
+            CORBA::Boolean next_n(CORBA::ULong how_many, CosNaming::BindingList_out bl)
+            {
+                if (how_many == 0)
+                    throw CORBA::BAD_PARAM();
+
+                boost::mutex::scoped_lock lock(mut);
+                CORBA::ULong count = std::min(how_many, list.length() - position);
+                bl = new CosNaming::BindingList(count);
+                bl->length(count);
+                for (CORBA::ULong i = 0; i < count; ++i)
+                    (*bl.ptr())[i] = list[position + i];
+                position += count;
+                return count > 0;
+            }
+
+            void destroy();
+
+        private:
+            PortableServer::POA_var poa;
+            boost::mutex mut;
+            CosNaming::BindingList list;
+            CORBA::ULong position;
+    };
+
+    // activates a servant on the given POA, which takes ownership of it
+    CORBA::Object_ptr activate(PortableServer::POA_ptr poa, PortableServer::ServantBase* servant)
+    {
+        PortableServer::ObjectId_var id = poa->activate_object(servant);
+        servant->_remove_ref();
+        return poa->id_to_reference(id);
+    }
+
+    // deactivates the object the current request has been made on
+    void deactivateCurrent()
+    {
+        CORBA::Object_var obj = RTT::corba::ApplicationServer::orb->resolve_initial_references("POACurrent");
+        PortableServer::Current_var current = PortableServer::Current::_narrow(obj);
+        PortableServer::POA_var poa = current->get_POA();
+        PortableServer::ObjectId_var id = current->get_object_id();
+        poa->deactivate_object(id);
+    }
+
+    void BindingIteratorImpl::destroy()
+    {
+        deactivateCurrent();
+    }
+}
+
+NamingContextImpl::NamingContextImpl(PortableServer::POA_ptr poa):
+    poa(PortableServer::POA::_duplicate(poa))
+{
+}
+
+PortableServer::POA_ptr NamingContextImpl::_default_POA()
+{
+    return PortableServer::POA::_duplicate(poa);
+}
+
+CosNaming::NamingContext_ptr NamingContextImpl::firstContext(const CosNaming::Name& n, CosNaming::Name& rest)
+{
+    CORBA::Object_var obj;
+    {
+        boost::mutex::scoped_lock lock(mut);
+        Bindings::const_iterator it = bindings.find(Key(n[0].id.in(), n[0].kind.in()));
+        if (it == bindings.end())
+            throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::missing_node, n);
+        if (it->second.type != CosNaming::ncontext)
+            throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::not_context, n);
+        obj = CORBA::Object::_duplicate(it->second.object);
+    }
+
+    rest.length(n.length() - 1);
+    for (CORBA::ULong i = 1; i < n.length(); ++i)
+        rest[i - 1] = n[i];
+    return CosNaming::NamingContext::_narrow(obj);
+}
+
+void NamingContextImpl::addBinding(const CosNaming::Name& n, CORBA::Object_ptr obj, CosNaming::BindingType type, bool replace)
+{
+    boost::mutex::scoped_lock lock(mut);
+    Key key(n[0].id.in(), n[0].kind.in());
+    Bindings::iterator it = bindings.find(key);
+    if (it != bindings.end())
+    {
+        if (!replace)
+            throw CosNaming::NamingContext::AlreadyBound();
+        // a rebind cannot change the type of a binding
+        if (it->second.type != type)
+            throw CosNaming::NamingContext::NotFound(type == CosNaming::ncontext ?
+                    CosNaming::NamingContext::not_context :
+                    CosNaming::NamingContext::not_object, n);
+    }
+
+    Binding& binding = bindings[key];
+    binding.object = CORBA::Object::_duplicate(obj);
+    binding.type = type;
+}
+
+void NamingContextImpl::bind(const CosNaming::Name& n, CORBA::Object_ptr obj)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->bind(rest, obj);
+    }
+    addBinding(n, obj, CosNaming::nobject, false);
+}
+
+void NamingContextImpl::rebind(const CosNaming::Name& n, CORBA::Object_ptr obj)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->rebind(rest, obj);
+    }
+    addBinding(n, obj, CosNaming::nobject, true);
+}
+
+void NamingContextImpl::bind_context(const CosNaming::Name& n, CosNaming::NamingContext_ptr nc)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->bind_context(rest, nc);
+    }
+    addBinding(n, nc, CosNaming::ncontext, false);
+}
+
+void NamingContextImpl::rebind_context(const CosNaming::Name& n, CosNaming::NamingContext_ptr nc)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->rebind_context(rest, nc);
+    }
+    addBinding(n, nc, CosNaming::ncontext, true);
+}
+
+CORBA::Object_ptr NamingContextImpl::resolve(const CosNaming::Name& n)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->resolve(rest);
+    }
+
+    boost::mutex::scoped_lock lock(mut);
+    Bindings::const_iterator it = bindings.find(Key(n[0].id.in(), n[0].kind.in()));
+    if (it == bindings.end())
+        throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::missing_node, n);
+    return CORBA::Object::_duplicate(it->second.object);
+}
+
+void NamingContextImpl::unbind(const CosNaming::Name& n)
+{
+    if (n.length() == 0)
+        throw CosNaming::NamingContext::InvalidName();
+    if (n.length() > 1)
+    {
+        CosNaming::Name rest;
+        CosNaming::NamingContext_var context = firstContext(n, rest);
+        return context->unbind(rest);
+    }
+
+    boost::mutex::scoped_lock lock(mut);
+    if (!bindings.erase(Key(n[0].id.in(), n[0].kind.in())))
+        throw CosNaming::NamingContext::NotFound(CosNaming::NamingContext::missing_node, n);
+}
+
+CosNaming::NamingContext_ptr NamingContextImpl::new_context()
+{
+    CORBA::Object_var obj = activate(poa, new NamingContextImpl(poa));
+    return CosNaming::NamingContext::_narrow(obj);
+}
+
+CosNaming::NamingContext_ptr NamingContextImpl::bind_new_context(const CosNaming::Name& n)
+{
+    CosNaming::NamingContext_var context = new_context();
+    try
+    {
+        bind_context(n, context);
+    }
+    catch(...)
+    {
+        context->destroy();
+        throw;
+    }
+    return context._retn();
+}
+
+void NamingContextImpl::destroy()
+{
+    {
+        boost::mutex::scoped_lock lock(mut);
+        if (!bindings.empty())
+            throw CosNaming::NamingContext::NotEmpty();
+    }
+    deactivateCurrent();
+}
+
+void NamingContextImpl::list(CORBA::ULong how_many, CosNaming::BindingList_out bl, CosNaming::BindingIterator_out bi)
+{
+    CosNaming::BindingList all;
+    {
+        boost::mutex::scoped_lock lock(mut);
+        all.length(bindings.size());
+        CORBA::ULong i = 0;
+        for (Bindings::const_iterator it = bindings.begin(); it != bindings.end(); ++it, ++i)
+        {
+            all[i].binding_name.length(1);
+            all[i].binding_name[0].id = CORBA::string_dup(it->first.first.c_str());
+            all[i].binding_name[0].kind = CORBA::string_dup(it->first.second.c_str());
+            all[i].binding_type = it->second.type;
+        }
+    }
+
+    CORBA::ULong count = std::min(how_many, all.length());
+    bl = new CosNaming::BindingList(count);
+    bl->length(count);
+    for (CORBA::ULong i = 0; i < count; ++i)
+        (*bl.ptr())[i] = all[i];
+
+    if (count < all.length())
+    {
+        CORBA::Object_var obj = activate(poa, new BindingIteratorImpl(poa, all, count));
+        bi = CosNaming::BindingIterator::_narrow(obj);
+    }
+    else
+        bi = CosNaming::BindingIterator::_nil();
+}
+
+NameService::NameService()
+{
+    CORBA::ORB_var orb = CORBA::ORB::_duplicate(RTT::corba::ApplicationServer::orb);
+    if(CORBA::is_nil(orb))
+        throw NameServiceClientError("Corba is not initialized. Call Orocos.initialize first.");
+
+    // The contexts other than the root one live in their own POA, so that
+    // they all get deactivated along with the name service
+    static int poa_count = 0;
+    std::string poa_name = "RunkitNameService" + boost::lexical_cast<std::string>(poa_count++);
+    CORBA::Object_var obj = orb->resolve_initial_references("RootPOA");
+    PortableServer::POA_var root_poa = PortableServer::POA::_narrow(obj);
+    PortableServer::POAManager_var manager = root_poa->the_POAManager();
+    CORBA::PolicyList policies;
+    contexts_poa = root_poa->create_POA(poa_name.c_str(), manager, policies);
+
+    // From here on, the POA and the root context must be released if the
+    // construction fails, as the destructor will not be called
+    PortableServer::ObjectId_var id = PortableServer::string_to_ObjectId("NameService");
+    bool root_activated = false;
+    try
+    {
+        // The omniINSPOA lets us choose the object key, which is what makes the
+        // root context reachable at corbaloc::host:port/NameService
+        obj = orb->resolve_initial_references("omniINSPOA");
+        ins_poa = PortableServer::POA::_narrow(obj);
+        NamingContextImpl* root = new NamingContextImpl(contexts_poa);
+        try
+        {
+            ins_poa->activate_object_with_id(id, root);
+        }
+        catch(...)
+        {
+            root->_remove_ref();
+            throw;
+        }
+        root->_remove_ref();
+        root_activated = true;
+        ins_poa->the_POAManager()->activate();
+        manager->activate();
+
+        obj = ins_poa->id_to_reference(id);
+        root_context = CosNaming::NamingContext::_narrow(obj);
+
+        // Get the address the ORB publishes for the root context
+        omniIOR* ior = root_context->_PR_getobj()->_getIOR();
+        const IOP::TaggedProfileList& profiles = ior->iopProfiles();
+        for (CORBA::ULong i = 0; i < profiles.length(); ++i)
+        {
+            if (profiles[i].tag != IOP::TAG_INTERNET_IOP)
+                continue;
+            IIOP::ProfileBody body;
+            IIOP::unmarshalProfile(profiles[i], body);
+            ip = body.address.host.in();
+            port = boost::lexical_cast<std::string>(body.address.port);
+            break;
+        }
+        ior->release();
+        if (ip.empty())
+            throw NameServiceClientError("the ORB does not publish any TCP endpoint");
+    }
+    catch(...)
+    {
+        // Do not let a failure of the cleanup hide the original error
+        try
+        {
+            if (root_activated)
+                ins_poa->deactivate_object(id);
+            contexts_poa->destroy(true, false);
+        }
+        catch(...) {}
+        throw;
+    }
+}
+
+NameService::~NameService()
+{
+    PortableServer::ObjectId_var id = PortableServer::string_to_ObjectId("NameService");
+    ins_poa->deactivate_object(id);
+    contexts_poa->destroy(true, false);
+}
+
+std::string NameService::getIp()
+{
+    return ip;
+}
+
+std::string NameService::getPort()
+{
+    return port;
+}
+
+std::string NameService::getIOR()
+{
+    CORBA::String_var s = RTT::corba::ApplicationServer::orb->object_to_string(root_context);
+    return std::string(s.in());
+}
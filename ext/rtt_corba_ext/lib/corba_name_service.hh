@@ -0,0 +1,89 @@
+/*
+ In-process CORBA name service.
+
+ The naming contexts are kept in memory, and served by the ORB of the
+ current process. The root context is reachable through the usual
+ corbaloc::host:port/NameService address, so that NameServiceClient
+ works with it unchanged.
+
+ This class is thread safe.
+
+*/
+
+#ifndef __CORBA_NAME_SERVICE_HPP__
+#define __CORBA_NAME_SERVICE_HPP__
+
+#include <map>
+#include <string>
+#include <omniORB4/CORBA.h>
+#include <omniORB4/Naming.hh>
+#include <boost/thread/mutex.hpp>
+
+namespace corba
+{
+    //Servant of a naming context whose bindings are kept in memory
+    class NamingContextImpl : public POA_CosNaming::NamingContext
+    {
+        public:
+            NamingContextImpl(PortableServer::POA_ptr poa);
+
+            PortableServer::POA_ptr _default_POA();
+
+            void bind(const CosNaming::Name& n, CORBA::Object_ptr obj);
+            void rebind(const CosNaming::Name& n, CORBA::Object_ptr obj);
+            void bind_context(const CosNaming::Name& n, CosNaming::NamingContext_ptr nc);
+            void rebind_context(const CosNaming::Name& n, CosNaming::NamingContext_ptr nc);
+            CORBA::Object_ptr resolve(const CosNaming::Name& n);
+            void unbind(const CosNaming::Name& n);
+            CosNaming::NamingContext_ptr new_context();
+            CosNaming::NamingContext_ptr bind_new_context(const CosNaming::Name& n);
+            void destroy();
+            void list(CORBA::ULong how_many, CosNaming::BindingList_out bl, CosNaming::BindingIterator_out bi);
+
+        private:
+            struct Binding
+            {
+                CORBA::Object_var object;
+                CosNaming::BindingType type;
+            };
+            typedef std::pair<std::string, std::string> Key;
+            typedef std::map<Key, Binding> Bindings;
+
+            // returns the context bound to the first component of a compound
+            // name, and the rest of the name
+            CosNaming::NamingContext_ptr firstContext(const CosNaming::Name& n, CosNaming::Name& rest);
+            void addBinding(const CosNaming::Name& n, CORBA::Object_ptr obj, CosNaming::BindingType type, bool replace);
+
+            PortableServer::POA_var poa;
+            boost::mutex mut;
+            Bindings bindings;
+    };
+
+    //Name service served by the ORB of the current process
+    class NameService
+    {
+        public:
+            // activates the root naming context under the NameService
+            // object key. The ORB must be initialized
+            NameService();
+            // deactivates the root naming context
+            ~NameService();
+
+            // returns the host and port under which the root context can be
+            // reached, i.e. the ip and port to give to NameServiceClient
+            std::string getIp();
+            std::string getPort();
+
+            // returns the IOR of the root context
+            std::string getIOR();
+
+        private:
+            PortableServer::POA_var ins_poa;
+            PortableServer::POA_var contexts_poa;
+            CosNaming::NamingContext_var root_context;
+            std::string ip;
+            std::string port;
+    };
+};
+
+#endif
@@ -6,6 +6,7 @@
 #define TOPIC "TaskContexts"    
 
 #include "corba_name_service_client.hh"
+#include "../parallel_calls.hh"
 using namespace corba;
 
 NameServiceClient::NameServiceClient(std::string name_service_ip,std::string name_service_port):
@@ -53,39 +54,97 @@ void NameServiceClient::abort()
     abort_flag = true;
 }
 
-std::vector<std::string> NameServiceClient::getTaskContextNames()
+// returns the context holding the task contexts or nil if there is none
+CosNaming::NamingContext_var NameServiceClient::getTaskContextsContext()
 {
     // no need to lock mutex getNameService is taking care of this.
-    abort_flag = false;
     CosNaming::Name server_name;
     server_name.length(1);
     server_name[0].id = CORBA::string_dup(TOPIC);
-    std::vector<std::string> task_names;
-    CosNaming::BindingList_var binding_list;
-    CosNaming::BindingIterator_var binding_it;
     CosNaming::NamingContext_var root_context = getNameService();
 
-    // get all available task names from the name server
     CORBA::Object_var control_tasks_var = root_context->resolve(server_name);
-    CosNaming::NamingContext_var control_tasks = CosNaming::NamingContext::_narrow (control_tasks_var);
-    if (CORBA::is_nil(control_tasks))
-        return task_names;
-
-    if(abort_flag)
-        return task_names;
+    return CosNaming::NamingContext::_narrow (control_tasks_var);
+}
 
-    control_tasks->list(0, binding_list, binding_it);
-    if (CORBA::is_nil(binding_it))
-        return task_names;
+std::vector<std::string> NameServiceClient::listBindings(CosNaming::NamingContext_ptr context, unsigned int chunk_size)
+{
+    std::vector<std::string> names;
+    CosNaming::BindingList_var binding_list;
+    CosNaming::BindingIterator_var binding_it;
 
-    // iterate over all task names
-    while(!abort_flag && binding_it->next_n(10, binding_list))
+    // the first chunk is returned by list itself
+    context->list(chunk_size, binding_list, binding_it);
+    while (true)
     {
-        CosNaming::BindingList list = binding_list.in();
+        CosNaming::BindingList const& list = binding_list.in();
         for (unsigned int i = 0; i < list.length(); ++i)
-            task_names.push_back(std::string(list[i].binding_name[0].id.in()));
+            names.push_back(std::string(list[i].binding_name[0].id.in()));
+
+        if (abort_flag || CORBA::is_nil(binding_it) || !binding_it->next_n(chunk_size, binding_list))
+            break;
+    }
+    if (!CORBA::is_nil(binding_it))
+        binding_it->destroy();
+    return names;
+}
+
+std::vector<std::string> NameServiceClient::getTaskContextNames(unsigned int chunk_size)
+{
+    abort_flag = false;
+    return listTaskContextNames(chunk_size);
+}
+
+std::vector<std::string> NameServiceClient::listTaskContextNames(unsigned int chunk_size)
+{
+    if (abort_flag)
+        return std::vector<std::string>();
+
+    CosNaming::NamingContext_var control_tasks = getTaskContextsContext();
+    if (CORBA::is_nil(control_tasks) || abort_flag)
+        return std::vector<std::string>();
+
+    return listBindings(control_tasks, chunk_size);
+}
+
+void NameServiceClient::resolveOne(CosNaming::NamingContext_ptr context, std::vector<std::string> const& names, std::vector<std::string>& iors, size_t i)
+{
+    if (abort_flag)
+        return;
+
+    CosNaming::Name name;
+    name.length(1);
+    name[0].id = CORBA::string_dup(names[i].c_str());
+    try
+    {
+        CORBA::Object_var task_object = context->resolve(name);
+        CORBA::String_var s = RTT::corba::ApplicationServer::orb->object_to_string(task_object);
+        iors[i] = s.in();
+    }
+    catch(CosNaming::NamingContext::NotFound) {}
+}
+
+std::map<std::string, std::string> NameServiceClient::resolveAll(unsigned int chunk_size, unsigned int max_threads)
+{
+    abort_flag = false;
+    std::map<std::string, std::string> result;
+    CosNaming::NamingContext_var control_tasks = getTaskContextsContext();
+    if (CORBA::is_nil(control_tasks) || abort_flag)
+        return result;
+
+    std::vector<std::string> names = listBindings(control_tasks, chunk_size);
+    std::vector<std::string> iors(names.size());
+    runkit::ParallelCalls(names.size(),
+            boost::bind(&NameServiceClient::resolveOne, this, control_tasks.in(),
+                boost::cref(names), boost::ref(iors), _1),
+            max_threads).run();
+
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        if (!iors[i].empty())
+            result[names[i]] = iors[i];
     }
-    return task_names;
+    return result;
 }
 
 void NameServiceClient::bind(CORBA::Object_var const &obj,std::string const& name)
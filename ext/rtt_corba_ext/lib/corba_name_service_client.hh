@@ -11,11 +11,13 @@
 #ifndef __CORBA_NAME_SERVICE_CLIENT_HPP__
 #define __CORBA_NAME_SERVICE_CLIENT_HPP__
 
+#include <map>
 #include <vector>
 #include <string>
 #include "TaskContextC.h"
 #include <rtt/transports/corba/TaskContextProxy.hpp>
 #include <boost/thread/mutex.hpp>
+#include <atomic>
 
 namespace corba
 {
@@ -40,7 +42,19 @@ namespace corba
             ~NameServiceClient();
             
             // returns all available task names which are bound to the name service
-            std::vector<std::string> getTaskContextNames();
+            // the bindings are listed chunk_size at a time
+            std::vector<std::string> getTaskContextNames(unsigned int chunk_size = 10);
+
+            // same as getTaskContextNames, but keeps a pending abort instead
+            // of clearing it. Once aborted, all the subsequent listings
+            // return early
+            std::vector<std::string> listTaskContextNames(unsigned int chunk_size = 10);
+
+            // returns the name and IOR of all task contexts which are bound to
+            // the name service. The bindings are listed chunk_size at a time,
+            // and resolved concurrently on up to max_threads threads. Names
+            // which got unbound in between are skipped
+            std::map<std::string, std::string> resolveAll(unsigned int chunk_size, unsigned int max_threads);
 
             // returns the port number of the used name service 
             std::string getPort();
@@ -68,6 +82,9 @@ namespace corba
             void abort();
 
         private:
+            CosNaming::NamingContext_var getTaskContextsContext();
+            std::vector<std::string> listBindings(CosNaming::NamingContext_ptr context, unsigned int chunk_size);
+            void resolveOne(CosNaming::NamingContext_ptr context, std::vector<std::string> const& names, std::vector<std::string>& iors, size_t i);
             CosNaming::NamingContext_var getNameService();
             CosNaming::NamingContext_var getNameService(const std::string name_service_ip, const std::string name_service_port);
 
@@ -76,7 +93,7 @@ namespace corba
             std::string name_service_ip;
             CosNaming::NamingContext_var root_context;
             boost::mutex mut;
-            bool abort_flag;
+            std::atomic<bool> abort_flag;
     };
 };
 
@@ -0,0 +1,206 @@
+#include "rtt-corba.hh"
+
+#include <typelib/typemodel.hh>
+#include <typelib_ruby.hh>
+#include <vector>
+
+#include <ruby/version.h>
+#if RUBY_API_VERSION_MAJOR >= 3
+#include <ruby/memory_view.h>
+#define HAS_RUBY_MEMORY_VIEW
+#endif
+
+using namespace runkit;
+
+namespace {
+    /** Description of the contiguous buffer of numeric values held by a
+     * typelib array or std::vector
+     */
+    struct SampleBuffer {
+        void* data;
+        size_t count;
+        Typelib::Numeric const* element;
+    };
+
+    /** Resolves the buffer of the given typelib value
+     *
+     * Returns false if the value is not an array or a std::vector of numeric
+     * values
+     */
+    bool resolve_sample_buffer(Typelib::Value value, SampleBuffer& buffer)
+    {
+        Typelib::Type const& type = value.getType();
+        Typelib::Type::Category category = type.getCategory();
+        if (category != Typelib::Type::Array && category != Typelib::Type::Container)
+            return false;
+
+        Typelib::Indirect const& indirect = static_cast<Typelib::Indirect const&>(type);
+        Typelib::Type const& element = indirect.getIndirection();
+        if (element.getCategory() != Typelib::Type::Numeric)
+            return false;
+        buffer.element = static_cast<Typelib::Numeric const*>(&element);
+
+        if (category == Typelib::Type::Array) {
+            buffer.data = value.getData();
+            buffer.count = static_cast<Typelib::Array const&>(type).getDimension();
+            return true;
+        }
+
+        Typelib::Container const& container =
+            static_cast<Typelib::Container const&>(type);
+        if (container.kind() != "/std/vector")
+            return false;
+
+        // Typelib stores the elements of /std/vector in a std::vector of
+        // bytes
+        std::vector<uint8_t>& raw =
+            *reinterpret_cast<std::vector<uint8_t>*>(value.getData());
+        buffer.count = container.getElementCount(value.getData());
+        buffer.data = raw.empty() ? NULL : &raw[0];
+        return true;
+    }
+
+    SampleBuffer get_sample_buffer(VALUE rb_value)
+    {
+        Typelib::Value value = typelib_get(rb_value);
+        SampleBuffer buffer;
+        if (!resolve_sample_buffer(value, buffer))
+            rb_raise(rb_eArgError,
+                "%s is neither an array nor a std::vector of numeric values",
+                value.getType().getName().c_str());
+        return buffer;
+    }
+}
+
+/** call-seq:
+ *     Runkit.sample_buffer(typelib_value) => frozen_string
+ *
+ * Returns a frozen String whose bytes are the elements of the given typelib
+ * array or std::vector of numeric values. The string shares the value's
+ * memory, and keeps the value alive.
+ *
+ * The value must not be resized while the string is in use, as it would
+ * reallocate the shared memory
+ */
+static VALUE sample_buffer(VALUE mod, VALUE rb_value)
+{
+    SampleBuffer buffer = get_sample_buffer(rb_value);
+    long size = buffer.count * buffer.element->getSize();
+    VALUE str = rb_str_new_static(static_cast<char*>(buffer.data), size);
+    // Hidden instance variable (no @), to tie the lifetime of the sample to
+    // the string's
+    rb_ivar_set(str, rb_intern("__typelib_sample"), rb_value);
+    return rb_obj_freeze(str);
+}
+
+#ifdef HAS_RUBY_MEMORY_VIEW
+static char const* memory_view_format(Typelib::Numeric const& element)
+{
+    size_t size = element.getSize();
+    switch (element.getNumericCategory()) {
+        case Typelib::Numeric::Float:
+            if (size == 4)
+                return "f";
+            else if (size == 8)
+                return "d";
+            return NULL;
+        case Typelib::Numeric::SInt:
+            switch (size) {
+                case 1:
+                    return "c";
+                case 2:
+                    return "s";
+                case 4:
+                    return "l";
+                case 8:
+                    return "q";
+            }
+            return NULL;
+        case Typelib::Numeric::UInt:
+            switch (size) {
+                case 1:
+                    return "C";
+                case 2:
+                    return "S";
+                case 4:
+                    return "L";
+                case 8:
+                    return "Q";
+            }
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+static bool memory_view_available_p(VALUE obj)
+{
+    SampleBuffer buffer;
+    if (!resolve_sample_buffer(typelib_get(obj), buffer))
+        return false;
+    return memory_view_format(*buffer.element) != NULL;
+}
+
+static bool memory_view_get(VALUE obj, rb_memory_view_t* view, int flags)
+{
+    SampleBuffer buffer;
+    if (!resolve_sample_buffer(typelib_get(obj), buffer))
+        return false;
+    char const* format = memory_view_format(*buffer.element);
+    if (!format)
+        return false;
+
+    ssize_t item_size = buffer.element->getSize();
+    if (!rb_memory_view_init_as_byte_array(view,
+            obj,
+            buffer.data,
+            buffer.count * item_size,
+            false))
+        return false;
+
+    view->format = format;
+    view->item_size = item_size;
+    view->ndim = 1;
+    view->shape = NULL;
+    view->strides = NULL;
+    return true;
+}
+
+static bool memory_view_release(VALUE obj, rb_memory_view_t* view)
+{
+    return true;
+}
+
+static rb_memory_view_entry_t const memory_view_entry = {
+    memory_view_get,
+    memory_view_release,
+    memory_view_available_p};
+#endif
+
+/** call-seq:
+ *     Runkit.do_register_memory_view(typelib_class) => true or false
+ *
+ * Registers the MemoryView export of sample buffers on the given typelib
+ * class (and its subclasses). Returns false if the Ruby version does not
+ * support MemoryView
+ */
+static VALUE register_memory_view(VALUE mod, VALUE klass)
+{
+#ifdef HAS_RUBY_MEMORY_VIEW
+    return rb_memory_view_register(klass, &memory_view_entry) ? Qtrue : Qfalse;
+#else
+    return Qfalse;
+#endif
+}
+
+void runkit::rtt_corba_init_memory_view(VALUE mRoot)
+{
+    rb_define_singleton_method(mRoot,
+        "sample_buffer",
+        RUBY_METHOD_FUNC(sample_buffer),
+        1);
+    rb_define_singleton_method(mRoot,
+        "do_register_memory_view",
+        RUBY_METHOD_FUNC(register_memory_view),
+        1);
+}
@@ -0,0 +1,410 @@
+#include "corba.hh"
+#include "lib/corba_name_service_client.hh"
+#include "rtt-corba.hh"
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <list>
+#include <fcntl.h>
+#include <set>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace runkit;
+
+static VALUE cNameServiceWatcher;
+
+namespace {
+    /** State shared between a watcher and its thread
+     *
+     * The thread holds a reference to it, so that the Ruby object can be
+     * garbage collected without waiting for the thread to finish its current
+     * poll
+     */
+    struct WatcherState {
+        corba::NameServiceClient client;
+        unsigned int period_ms;
+        unsigned int chunk_size;
+
+        boost::mutex mutex;
+        boost::condition_variable cond;
+        bool quit;
+        /** Set by the thread when it exits */
+        bool finished;
+
+        /** Changes not yet read by Ruby, as (added, name) pairs */
+        std::deque<std::pair<bool, std::string>> changes;
+        /** Pipe that becomes readable when there are changes */
+        int notify_fds[2];
+
+        uint64_t polls;
+        uint64_t errors;
+        double last_duration;
+        double total_duration;
+        size_t name_count;
+        std::string last_error;
+
+        WatcherState(std::string const& ip,
+            std::string const& port,
+            unsigned int period_ms,
+            unsigned int chunk_size)
+            : client(ip, port)
+            , period_ms(period_ms)
+            , chunk_size(chunk_size)
+            , quit(false)
+            , finished(false)
+            , polls(0)
+            , errors(0)
+            , last_duration(0)
+            , total_duration(0)
+            , name_count(0)
+        {
+            notify_fds[0] = -1;
+            notify_fds[1] = -1;
+        }
+
+        ~WatcherState()
+        {
+            if (notify_fds[0] != -1) {
+                close(notify_fds[0]);
+                close(notify_fds[1]);
+            }
+        }
+    };
+    typedef boost::shared_ptr<WatcherState> WatcherStatePtr;
+
+    typedef boost::shared_ptr<boost::thread> ThreadPtr;
+
+    /** Asks a watcher thread to quit, and aborts its current listing */
+    void stop_watcher(WatcherState& state)
+    {
+        {
+            boost::mutex::scoped_lock lock(state.mutex);
+            state.quit = true;
+            state.cond.notify_all();
+        }
+        state.client.abort();
+    }
+
+    struct RNameServiceWatcher {
+        WatcherStatePtr state;
+        ThreadPtr thread;
+
+        /** Set by the abort function of #do_stop to stop waiting for the
+         * thread
+         */
+        bool join_interrupted;
+    };
+
+    /** The watcher threads that may still be running
+     *
+     * A watcher that gets garbage collected only asks its thread to quit, as
+     * joining it would block the GC until the current listing finishes.
+     * The threads are all joined by name_service_watchers_shutdown, before
+     * the ORB they use gets destroyed. The list is only accessed with the
+     * GVL held
+     */
+    typedef std::list<std::pair<WatcherStatePtr, ThreadPtr>> WatcherThreads;
+    WatcherThreads watcher_threads;
+
+    bool is_finished(WatcherState& state)
+    {
+        boost::mutex::scoped_lock lock(state.mutex);
+        return state.finished;
+    }
+
+    /** Joins and removes the threads that are finished from watcher_threads
+     *
+     * Only this function and name_service_watchers_shutdown join the
+     * threads, which are both called with the GVL held
+     */
+    void prune_watcher_threads()
+    {
+        WatcherThreads::iterator it = watcher_threads.begin();
+        while (it != watcher_threads.end()) {
+            if (is_finished(*it->first)) {
+                it->second->join();
+                it = watcher_threads.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    double monotonic_time()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec + now.tv_nsec * 1e-9;
+    }
+
+    /** Marks the watcher state as finished when the thread exits */
+    struct FinishedGuard {
+        WatcherState& state;
+        FinishedGuard(WatcherState& state)
+            : state(state)
+        {
+        }
+        ~FinishedGuard()
+        {
+            boost::mutex::scoped_lock lock(state.mutex);
+            state.finished = true;
+            state.cond.notify_all();
+        }
+    };
+
+    void watch(WatcherStatePtr state)
+    {
+        FinishedGuard guard(*state);
+        std::set<std::string> snapshot;
+        while (true) {
+            {
+                boost::mutex::scoped_lock lock(state->mutex);
+                if (state->quit)
+                    return;
+            }
+
+            double start = monotonic_time();
+            std::vector<std::string> names;
+            std::string error;
+            try {
+                // getTaskContextNames would clear an abort issued by
+                // stop_watcher just before the listing
+                names = state->client.listTaskContextNames(state->chunk_size);
+            }
+            catch (CosNaming::NamingContext::NotFound&) {
+                // No task context has ever been registered
+            }
+            catch (CORBA::Exception& e) {
+                error = e._name();
+            }
+            catch (std::exception& e) {
+                error = e.what();
+            }
+            double duration = monotonic_time() - start;
+
+            boost::mutex::scoped_lock lock(state->mutex);
+            if (state->quit)
+                return;
+
+            ++state->polls;
+            state->last_duration = duration;
+            state->total_duration += duration;
+            if (!error.empty()) {
+                // Keep the snapshot as-is, a name service that cannot be
+                // reached does not mean that the tasks are gone
+                ++state->errors;
+                state->last_error = error;
+            }
+            else {
+                std::set<std::string> current(names.begin(), names.end());
+                size_t change_count = state->changes.size();
+                for (std::set<std::string>::const_iterator it = current.begin();
+                     it != current.end();
+                     ++it) {
+                    if (!snapshot.count(*it))
+                        state->changes.push_back(std::make_pair(true, *it));
+                }
+                for (std::set<std::string>::const_iterator it = snapshot.begin();
+                     it != snapshot.end();
+                     ++it) {
+                    if (!current.count(*it))
+                        state->changes.push_back(std::make_pair(false, *it));
+                }
+                snapshot.swap(current);
+                state->name_count = snapshot.size();
+
+                if (state->changes.size() != change_count) {
+                    char byte = 0;
+                    ssize_t ret = write(state->notify_fds[1], &byte, 1);
+                    (void)ret;
+                }
+            }
+
+            state->cond.timed_wait(lock, boost::posix_time::milliseconds(state->period_ms));
+            if (state->quit)
+                return;
+        }
+    }
+
+    void delete_watcher(RNameServiceWatcher* watcher)
+    {
+        stop_watcher(*watcher->state);
+        delete watcher;
+    }
+
+    /** Waits for the thread of a watcher to finish, or for #do_stop to be
+     * interrupted
+     */
+    void join_watcher(RNameServiceWatcher* watcher)
+    {
+        WatcherState& state = *watcher->state;
+        boost::mutex::scoped_lock lock(state.mutex);
+        while (!state.finished && !watcher->join_interrupted)
+            state.cond.wait(lock);
+    }
+
+    void interrupt_join_watcher(RNameServiceWatcher* watcher)
+    {
+        stop_watcher(*watcher->state);
+        boost::mutex::scoped_lock lock(watcher->state->mutex);
+        watcher->join_interrupted = true;
+        watcher->state->cond.notify_all();
+    }
+
+    RNameServiceWatcher& get_watcher(VALUE self)
+    {
+        return get_wrapped<RNameServiceWatcher>(self);
+    }
+}
+
+/** call-seq:
+ *     do_watch(period_ms, chunk_size) => watcher
+ *
+ * Starts a thread that lists the task contexts registered on this name
+ * service every period_ms milliseconds, and reports the names that appeared
+ * or disappeared since the previous listing. The first listing reports all
+ * the registered names
+ */
+static VALUE name_service_watch(VALUE self, VALUE period_ms, VALUE chunk_size)
+{
+    corba_must_be_initialized();
+
+    corba::NameServiceClient& name_service = get_wrapped<corba::NameServiceClient>(self);
+    WatcherStatePtr state(new WatcherState(name_service.getIp(),
+        name_service.getPort(),
+        NUM2UINT(period_ms),
+        NUM2UINT(chunk_size)));
+    if (pipe2(state->notify_fds, O_CLOEXEC | O_NONBLOCK) == -1) {
+        state->notify_fds[0] = -1;
+        state->notify_fds[1] = -1;
+        rb_sys_fail("failed to create the notification pipe");
+    }
+
+    prune_watcher_threads();
+    std::unique_ptr<RNameServiceWatcher> watcher(new RNameServiceWatcher);
+    watcher->state = state;
+    watcher->join_interrupted = false;
+    watcher->thread.reset(new boost::thread(boost::bind(&watch, state)));
+    watcher_threads.push_back(std::make_pair(state, watcher->thread));
+    return Data_Wrap_Struct(cNameServiceWatcher, 0, delete_watcher, watcher.release());
+}
+
+/** call-seq:
+ *     do_notification_fd => fd
+ *
+ * A file descriptor that becomes readable when there are changes to be read
+ * with #do_pop_changes
+ */
+static VALUE watcher_notification_fd(VALUE self)
+{
+    return INT2FIX(get_watcher(self).state->notify_fds[0]);
+}
+
+/** call-seq:
+ *     do_pop_changes => [[added, name], ...]
+ *
+ * Returns the changes that happened since the last call, in order. added is
+ * true for a name that appeared and false for a name that disappeared
+ */
+static VALUE watcher_pop_changes(VALUE self)
+{
+    WatcherState& state = *get_watcher(self).state;
+    std::deque<std::pair<bool, std::string>> changes;
+    {
+        boost::mutex::scoped_lock lock(state.mutex);
+        char buffer[256];
+        while (read(state.notify_fds[0], buffer, sizeof(buffer)) > 0)
+            ;
+        changes.swap(state.changes);
+    }
+
+    VALUE result = rb_ary_new_capa(changes.size());
+    for (size_t i = 0; i < changes.size(); ++i) {
+        VALUE change = rb_ary_new_capa(2);
+        rb_ary_push(change, changes[i].first ? Qtrue : Qfalse);
+        rb_ary_push(change, rb_str_new(changes[i].second.c_str(), changes[i].second.size()));
+        rb_ary_push(result, change);
+    }
+    return result;
+}
+
+/** call-seq:
+ *     do_stats => {polls:, errors:, last_duration:, total_duration:, name_count:, last_error:}
+ *
+ * The cost of the polling done by the watcher thread. The durations are in
+ * seconds
+ */
+static VALUE watcher_stats(VALUE self)
+{
+    WatcherState& state = *get_watcher(self).state;
+    boost::mutex::scoped_lock lock(state.mutex);
+    VALUE result = rb_hash_new();
+    rb_hash_aset(result, ID2SYM(rb_intern("polls")), ULL2NUM(state.polls));
+    rb_hash_aset(result, ID2SYM(rb_intern("errors")), ULL2NUM(state.errors));
+    rb_hash_aset(result,
+        ID2SYM(rb_intern("last_duration")),
+        DBL2NUM(state.last_duration));
+    rb_hash_aset(result,
+        ID2SYM(rb_intern("total_duration")),
+        DBL2NUM(state.total_duration));
+    rb_hash_aset(result, ID2SYM(rb_intern("name_count")), SIZET2NUM(state.name_count));
+    rb_hash_aset(result,
+        ID2SYM(rb_intern("last_error")),
+        state.last_error.empty() ? Qnil : rb_str_new2(state.last_error.c_str()));
+    return result;
+}
+
+/** call-seq:
+ *     do_stop
+ *
+ * Stops the watcher thread and waits for it to finish. If the wait gets
+ * interrupted, the thread finishes in the background
+ */
+static VALUE watcher_stop(VALUE self)
+{
+    RNameServiceWatcher& watcher = get_watcher(self);
+    stop_watcher(*watcher.state);
+    {
+        boost::mutex::scoped_lock lock(watcher.state->mutex);
+        watcher.join_interrupted = false;
+    }
+    blocking_fct_call(boost::bind(&join_watcher, &watcher),
+        boost::bind(&interrupt_join_watcher, &watcher));
+    return Qnil;
+}
+
+void runkit::name_service_watchers_shutdown()
+{
+    for (WatcherThreads::iterator it = watcher_threads.begin();
+         it != watcher_threads.end();
+         ++it)
+        stop_watcher(*it->first);
+    for (WatcherThreads::iterator it = watcher_threads.begin();
+         it != watcher_threads.end();
+         ++it) {
+        if (it->second->joinable())
+            it->second->join();
+    }
+    watcher_threads.clear();
+}
+
+void runkit::rtt_corba_init_name_service_watcher()
+{
+    cNameServiceWatcher = rb_define_class_under(cNameService, "Watcher", rb_cObject);
+    rb_undef_alloc_func(cNameServiceWatcher);
+    rb_define_method(cNameService, "do_watch", RUBY_METHOD_FUNC(name_service_watch), 2);
+    rb_define_method(cNameServiceWatcher,
+        "do_notification_fd",
+        RUBY_METHOD_FUNC(watcher_notification_fd),
+        0);
+    rb_define_method(cNameServiceWatcher,
+        "do_pop_changes",
+        RUBY_METHOD_FUNC(watcher_pop_changes),
+        0);
+    rb_define_method(cNameServiceWatcher, "do_stats", RUBY_METHOD_FUNC(watcher_stats), 0);
+    rb_define_method(cNameServiceWatcher, "do_stop", RUBY_METHOD_FUNC(watcher_stop), 0);
+}
@@ -1,5 +1,7 @@
+#include "async_call.hh"
 #include "corba.hh"
 #include "rtt-corba.hh"
+#include <map>
 #include <memory>
 #include <typeinfo>
 #include <typelib_ruby.hh>
@@ -71,7 +73,7 @@ static VALUE operation_call(VALUE task_,
     RTaskContext& task = get_wrapped<RTaskContext>(task_);
     CAnyArguments_var corba_args = corba_args_from_ruby(args_type_names, args);
 
-    CORBA::Any_var corba_result = corba_blocking_fct_call_with_result(
+    CORBA::Any_var corba_result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_COperationInterface::callOperation,
             (_objref_COperationInterface*)task.main_service,
             StringValuePtr(name),
@@ -85,6 +87,87 @@ static VALUE operation_call(VALUE task_,
     return result;
 }
 
+namespace {
+    struct OperationCall : public AsyncCall {
+        RTT::corba::CService_var service;
+        std::string name;
+        CAnyArguments_var corba_args;
+        CORBA::Any_var corba_result;
+        VALUE result_type_name;
+        VALUE result;
+        VALUE args_type_names;
+        VALUE args;
+
+        OperationCall(RTT::corba::CService_ptr service,
+            std::string const& name,
+            CAnyArguments* corba_args,
+            VALUE result_type_name,
+            VALUE result,
+            VALUE args_type_names,
+            VALUE args)
+            : service(RTT::corba::CService::_duplicate(service))
+            , name(name)
+            , corba_args(corba_args)
+            , result_type_name(result_type_name)
+            , result(result)
+            , args_type_names(args_type_names)
+            , args(args)
+        {
+        }
+
+        void run()
+        {
+            corba_result = service->callOperation(name.c_str(), corba_args.inout());
+        }
+
+        VALUE toRuby()
+        {
+            if (!NIL_P(result)) {
+                Typelib::Value v = typelib_get(result);
+                corba_to_ruby(StringValuePtr(result_type_name), v, corba_result.inout());
+            }
+            corba_args_to_ruby(args_type_names, args, corba_args.inout());
+            return result;
+        }
+
+        void mark()
+        {
+            rb_gc_mark(result_type_name);
+            rb_gc_mark(result);
+            rb_gc_mark(args_type_names);
+            rb_gc_mark(args);
+        }
+    };
+}
+
+/** call-seq:
+ *     do_operation_call_async(name, result_type_name, result, args_type_names, args)
+ *       => async_call
+ *
+ * Asynchronous version of #do_operation_call. The arguments are marshalled
+ * right away. The returned Runkit::AsyncCall's value is +result+, and the
+ * arguments are updated as well when the value is read
+ */
+static VALUE operation_call_async(VALUE task_,
+    VALUE name,
+    VALUE result_type_name,
+    VALUE result,
+    VALUE args_type_names,
+    VALUE args)
+{
+    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+    CAnyArguments_var corba_args = corba_args_from_ruby(args_type_names, args);
+    boost::shared_ptr<AsyncCall> call(new OperationCall(task.main_service.in(),
+        StringValuePtr(name),
+        corba_args._retn(),
+        result_type_name,
+        result,
+        args_type_names,
+        args));
+    call->setTask(task_);
+    return async_call_start(call);
+}
+
 struct RSendHandle {
     RSendHandle()
     {
@@ -113,7 +196,7 @@ static VALUE operation_send(VALUE task_, VALUE name, VALUE args_type_names, VALU
     RTaskContext& task = get_wrapped<RTaskContext>(task_);
     CAnyArguments_var corba_args = corba_args_from_ruby(args_type_names, args);
 
-    RTT::corba::CSendHandle_var corba_result = corba_blocking_fct_call_with_result(
+    RTT::corba::CSendHandle_var corba_result = task_blocking_fct_call_with_result(task,
         boost::bind(&_objref_COperationInterface::sendOperation,
             (_objref_COperationInterface*)task.main_service,
             StringValuePtr(name),
@@ -151,61 +234,190 @@ static VALUE send_handle_collect(VALUE handle_, VALUE result_type_names, VALUE r
     return INT2FIX(ss);
 }
 
-static VALUE operation_return_types(VALUE task_, VALUE opname)
-{
-    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+namespace {
+    /** Data exchanged with fetch_operation_signature */
+    struct OperationSignatureQuery {
+        RTaskContext* context;
+        std::string name;
+        /** Whether the descriptions of all operations should be read */
+        bool fetch_descriptions;
+        /** The descriptions of all operations, if fetch_descriptions is set */
+        std::map<std::string, OperationSignature> descriptions;
+        /** The signature being resolved. It may already have its description */
+        OperationSignature signature;
+    };
 
-    VALUE result = rb_ary_new();
-    int retcount = corba_blocking_fct_call_with_result(
-        boost::bind(&_objref_COperationInterface::getCollectArity,
-            (_objref_COperationInterface*)task.main_service,
-            StringValuePtr(opname)));
-
-    CORBA::String_var type_name = corba_blocking_fct_call_with_result(
-        boost::bind(&_objref_COperationInterface::getResultType,
-            (_objref_COperationInterface*)task.main_service,
-            StringValuePtr(opname)));
-    rb_ary_push(result, rb_str_new2(type_name));
-
-    for (int i = 0; i < retcount - 1; ++i) {
-        type_name = corba_blocking_fct_call_with_result(
-            boost::bind(&_objref_COperationInterface::getCollectType,
-                (_objref_COperationInterface*)task.main_service,
-                StringValuePtr(opname),
-                i + 1));
-        rb_ary_push(result, rb_str_new2(type_name));
+    template <typename Arguments>
+    void read_arguments(OperationSignature& signature, Arguments const& args)
+    {
+        signature.arguments.resize(args.length());
+        for (unsigned int i = 0; i < args.length(); ++i) {
+            OperationSignature::Argument& arg = signature.arguments[i];
+            arg.name = args[i].name.in();
+            arg.description = args[i].description.in();
+            arg.type = args[i].type.in();
+        }
     }
-    return result;
-}
 
-static VALUE operation_argument_types(VALUE task_, VALUE opname)
-{
-    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+    /** Resolves the signature of query.name
+     *
+     * It is called with the GVL released, and must therefore not touch the
+     * RTaskContext's cache
+     */
+    void fetch_operation_signature(OperationSignatureQuery* query)
+    {
+        _objref_COperationInterface* operations =
+            (_objref_COperationInterface*)query->context->main_service;
+        char const* name = query->name.c_str();
+        OperationSignature& signature = query->signature;
+
+#if RTT_VERSION_GTE(2, 8, 99)
+        // getOperations describes all operations at once. Store them all, so
+        // that further lookups only need the collect types
+        if (query->fetch_descriptions) {
+            RTT::corba::COperationInterface::COperationDescriptions_var descriptions =
+                operations->getOperations();
+            for (unsigned int i = 0; i < descriptions->length(); ++i) {
+                OperationSignature& description =
+                    query->descriptions[descriptions[i].name.in()];
+                description.has_description = true;
+                description.return_types.push_back(descriptions[i].ret.in());
+                read_arguments(description, descriptions[i].arguments);
+            }
 
-    VALUE result = rb_ary_new();
+            std::map<std::string, OperationSignature>::const_iterator it =
+                query->descriptions.find(query->name);
+            if (it != query->descriptions.end())
+                signature = it->second;
+        }
+#endif
 
+        if (!signature.has_description) {
+            CORBA::String_var result_type = operations->getResultType(name);
+            signature.return_types.push_back(result_type.in());
 #if RTT_VERSION_GTE(2, 8, 99)
-    RTT::corba::CArgumentDescriptions_var args = corba_blocking_fct_call_with_result(
-        boost::bind(&_objref_COperationInterface::getArguments,
-            (_objref_COperationInterface*)task.main_service,
-            StringValuePtr(opname)));
+            RTT::corba::CArgumentDescriptions_var args = operations->getArguments(name);
 #else
-    RTT::corba::CDescriptions_var args = corba_blocking_fct_call_with_result(
-        boost::bind(&_objref_COperationInterface::getArguments,
-            (_objref_COperationInterface*)task.main_service,
-            StringValuePtr(opname)));
+            RTT::corba::CDescriptions_var args = operations->getArguments(name);
 #endif
+            read_arguments(signature, args.in());
+            signature.has_description = true;
+        }
 
-    for (unsigned int i = 0; i < args->length(); ++i) {
-        RTT::corba::CArgumentDescription arg = args[i];
-        VALUE tuple = rb_ary_new();
-        rb_ary_push(tuple, rb_str_new2(arg.name));
-        rb_ary_push(tuple, rb_str_new2(arg.description));
-        rb_ary_push(tuple, rb_str_new2(arg.type));
-        rb_ary_push(result, tuple);
+        int retcount = operations->getCollectArity(name);
+        for (int i = 0; i < retcount - 1; ++i) {
+            CORBA::String_var type_name = operations->getCollectType(name, i + 1);
+            signature.return_types.push_back(type_name.in());
+        }
+        signature.complete = true;
     }
-    return result;
-    return Qnil; // never reached
+
+    /** Adds the descriptions fetched by a query to the task's cache */
+    void cache_descriptions(RTaskContext& task, OperationSignatureQuery const& query)
+    {
+        std::map<std::string, OperationSignature>& cache = task.operation_signatures;
+        for (std::map<std::string, OperationSignature>::const_iterator it =
+                 query.descriptions.begin();
+             it != query.descriptions.end();
+             ++it) {
+            if (cache.find(it->first) == cache.end())
+                cache.insert(*it);
+        }
+    }
+
+    /** Called with the GVL held when fetch_operation_signature failed
+     *
+     * The descriptions may have been fetched before the failure (e.g. if the
+     * operation does not exist), so they are kept
+     */
+    void fetch_operation_signature_failed(OperationSignatureQuery* query,
+        VALUE exception_class)
+    {
+        cache_descriptions(*query->context, *query);
+        task_call_failed(query->context, exception_class);
+    }
+
+    /** Returns the signature of the given operation, resolving it only on the
+     * first call
+     */
+    OperationSignature const& resolve_operation_signature(RTaskContext& task,
+        std::string const& name)
+    {
+        std::map<std::string, OperationSignature>& cache = task.operation_signatures;
+        std::map<std::string, OperationSignature>::const_iterator cached =
+            cache.find(name);
+        if (cached != cache.end() && cached->second.complete)
+            return cached->second;
+
+        OperationSignatureQuery query;
+        query.context = &task;
+        query.name = name;
+        query.fetch_descriptions = cache.empty();
+        if (cached != cache.end())
+            query.signature = cached->second;
+
+        CORBABlockingFunction<boost::function<void()>>::call(
+            boost::bind(&fetch_operation_signature, &query),
+            boost::bind(&BlockingFunctionBase::abort_default),
+            boost::bind(&fetch_operation_signature_failed, &query, _1));
+
+        cache_descriptions(task, query);
+        return (cache[name] = query.signature);
+    }
+
+    VALUE return_types_to_ruby(OperationSignature const& signature)
+    {
+        VALUE result = rb_ary_new();
+        for (size_t i = 0; i < signature.return_types.size(); ++i)
+            rb_ary_push(result, rb_str_new2(signature.return_types[i].c_str()));
+        return result;
+    }
+
+    VALUE arguments_to_ruby(OperationSignature const& signature)
+    {
+        VALUE result = rb_ary_new();
+        for (size_t i = 0; i < signature.arguments.size(); ++i) {
+            OperationSignature::Argument const& arg = signature.arguments[i];
+            VALUE tuple = rb_ary_new();
+            rb_ary_push(tuple, rb_str_new2(arg.name.c_str()));
+            rb_ary_push(tuple, rb_str_new2(arg.description.c_str()));
+            rb_ary_push(tuple, rb_str_new2(arg.type.c_str()));
+            rb_ary_push(result, tuple);
+        }
+        return result;
+    }
+}
+
+/** call-seq:
+ *     operation_signature(name) => [return_types, arguments]
+ *
+ * Returns the return types (result type followed by the collected arguments)
+ * and the [name, description, type] tuples of the arguments of an operation.
+ *
+ * The remote calls needed to build it are all done within a single GVL
+ * release, and the result is cached for the lifetime of the task object.
+ */
+static VALUE operation_signature(VALUE task_, VALUE opname)
+{
+    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+    OperationSignature const& signature =
+        resolve_operation_signature(task, StringValuePtr(opname));
+    return rb_ary_new_from_args(2,
+        return_types_to_ruby(signature),
+        arguments_to_ruby(signature));
+}
+
+static VALUE operation_return_types(VALUE task_, VALUE opname)
+{
+    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+    return return_types_to_ruby(
+        resolve_operation_signature(task, StringValuePtr(opname)));
+}
+
+static VALUE operation_argument_types(VALUE task_, VALUE opname)
+{
+    RTaskContext& task = get_wrapped<RTaskContext>(task_);
+    return arguments_to_ruby(resolve_operation_signature(task, StringValuePtr(opname)));
 }
 
 void runkit::rtt_corba_init_operations(VALUE mRoot, VALUE cTaskContext)
@@ -213,6 +425,10 @@ void runkit::rtt_corba_init_operations(VALUE mRoot, VALUE cTaskContext)
     VALUE cOperation = rb_define_class_under(mRoot, "Operation", rb_cObject);
     cSendHandle = rb_define_class_under(mRoot, "SendHandle", rb_cObject);
 
+    rb_define_method(cTaskContext,
+        "operation_signature",
+        RUBY_METHOD_FUNC(operation_signature),
+        1);
     rb_define_method(cTaskContext,
         "operation_return_types",
         RUBY_METHOD_FUNC(operation_return_types),
@@ -225,6 +441,10 @@ void runkit::rtt_corba_init_operations(VALUE mRoot, VALUE cTaskContext)
         "do_operation_call",
         RUBY_METHOD_FUNC(operation_call),
         5);
+    rb_define_method(cTaskContext,
+        "do_operation_call_async",
+        RUBY_METHOD_FUNC(operation_call_async),
+        5);
     rb_define_method(cTaskContext,
         "do_operation_send",
         RUBY_METHOD_FUNC(operation_send),
@@ -0,0 +1,126 @@
+#ifndef RUNKIT_CORBA_EXT_PARALLEL_CALLS_HH
+#define RUNKIT_CORBA_EXT_PARALLEL_CALLS_HH
+
+#include "call_timeout.hh"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <exception>
+
+namespace runkit {
+    /** Queues a job on the pool of worker threads that also executes the
+     * asynchronous calls (see AsyncCall)
+     *
+     * The pool is created on first use. This can be called without the GVL
+     */
+    void submit_worker_job(boost::function<void()> const& job);
+
+    /** Returns the number of threads of the worker pool used by
+     * submit_worker_job
+     */
+    size_t worker_pool_size();
+
+    /** Calls f(i) for each i in [0, count) using up to max_threads threads
+     *
+     * The calls are made by the calling thread and by the threads of the
+     * worker pool (see submit_worker_job), so that no thread gets created
+     * per call. The calling thread takes part, which guarantees progress
+     * even if all the workers are busy. max_threads is therefore clamped to
+     * worker_pool_size() + 1.
+     *
+     * The CORBA call timeout set on the calling thread by ThreadCallTimeout
+     * when the object is created applies to all the calls.
+     *
+     * The first exception thrown by one of the calls is re-thrown in the
+     * calling thread once all the started calls are finished
+     */
+    class ParallelCalls {
+    public:
+        typedef boost::function<void(size_t)> Function;
+
+        ParallelCalls(size_t count, Function f, size_t max_threads)
+            : state(new State(count, f, ThreadCallTimeout::current()))
+            , max_threads(max_threads)
+        {
+        }
+
+        void run()
+        {
+            size_t thread_count = std::min(
+                state->count, std::min(max_threads, worker_pool_size() + 1));
+            for (size_t i = 1; i < thread_count; ++i)
+                submit_worker_job(boost::bind(&ParallelCalls::worker, state));
+            worker(state);
+
+            boost::mutex::scoped_lock lock(state->mutex);
+            while (state->active)
+                state->cond.wait(lock);
+            if (state->error)
+                std::rethrow_exception(state->error);
+        }
+
+    private:
+        /** The state shared with the workers
+         *
+         * The jobs queued on the pool may start after run() returned, so it
+         * is reference-counted. f is not called anymore once run() returned
+         */
+        struct State {
+            boost::mutex mutex;
+            boost::condition_variable cond;
+            size_t count;
+            size_t next;
+            size_t active;
+            Function f;
+            CORBA::ULong call_timeout;
+            std::exception_ptr error;
+
+            State(size_t count, Function f, CORBA::ULong call_timeout)
+                : count(count)
+                , next(0)
+                , active(0)
+                , f(f)
+                , call_timeout(call_timeout)
+            {
+            }
+        };
+
+        boost::shared_ptr<State> state;
+        size_t max_threads;
+
+        static void worker(boost::shared_ptr<State> state)
+        {
+            while (true) {
+                size_t i;
+                {
+                    boost::mutex::scoped_lock lock(state->mutex);
+                    if (state->next == state->count || state->error)
+                        return;
+                    i = state->next++;
+                    ++state->active;
+                }
+
+                std::exception_ptr error;
+                try {
+                    ThreadCallTimeout timeout(state->call_timeout);
+                    state->f(i);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+
+                boost::mutex::scoped_lock lock(state->mutex);
+                if (error && !state->error)
+                    state->error = error;
+                --state->active;
+                state->cond.notify_all();
+            }
+        }
+    };
+}
+
+#endif
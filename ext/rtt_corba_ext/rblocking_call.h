@@ -27,6 +27,18 @@ public:
     VALUE exception_class;         // stores the exception class
     std::string exception_message; // stores the message of the exeption
 
+    // called if no abort function is
+    // specified. We cannot test on empty() as
+    // F and A might be of type boost::_bi::bind_t
+    static void abort_default()
+    {
+    }
+
+    // called if no error function is specified
+    static void error_default(VALUE)
+    {
+    }
+
 protected:
     virtual void processing() = 0;
     virtual void abort() = 0;
@@ -72,13 +84,6 @@ protected:
         this->exception_message = message;
     }
 
-    // called if no abort function is
-    // specified. We cannot test on empty() as
-    // F and A might be of type boost::_bi::bind_t
-    static void abort_default()
-    {
-    }
-
     /** Generic implementation of blocking function call mechanisms
      *
      * The main problem this deals with is that the Ruby exceptions must be
@@ -86,6 +91,23 @@ protected:
      */
     template <typename ResultT, typename BlockingFunctionT, typename F, typename A>
     static ResultT doCall(F processing, A abort)
+    {
+        return doCall<ResultT, BlockingFunctionT>(processing,
+            abort,
+            &BlockingFunctionBase::error_default);
+    }
+
+    /** Generic implementation of blocking function call mechanisms
+     *
+     * on_error is called with the exception class, with the GVL held, before
+     * the exception gets raised
+     */
+    template <typename ResultT,
+        typename BlockingFunctionT,
+        typename F,
+        typename A,
+        typename E>
+    static ResultT doCall(F processing, A abort, E on_error)
     {
         VALUE exception_class;
         std::string exception_message;
@@ -100,6 +122,7 @@ protected:
                 return bf.ret();
         }
         // This is reached only if there is an exception
+        on_error(exception_class);
         ::rb_raise(exception_class, "%s", exception_message.c_str());
     }
 
@@ -1,8 +1,12 @@
 #include <typeinfo>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <exception>
 #include <memory>
 
+#include <rtt/TaskContext.hpp>
 #include <rtt/base/PortInterface.hpp>
 #include <rtt/plugin/PluginLoader.hpp>
 #include <rtt/transports/corba/CorbaConnPolicy.hpp>
@@ -24,7 +28,9 @@
 #include <sys/stat.h>
 #endif
 
+#include "async_call.hh"
 #include "corba.hh"
+#include "parallel_calls.hh"
 #include "rtt-corba.hh"
 #include <typelib_ruby.hh>
 
@@ -125,8 +131,94 @@ boost::tuple<RTaskContext*, VALUE, VALUE> runkit::get_port_reference(VALUE port)
     return boost::make_tuple(&task_context, task_name, port_name);
 }
 
+namespace {
+    /** The RTaskContext objects created by task_context_create, indexed by
+     * IOR
+     *
+     * The table does not own the objects: an entry is removed when the last
+     * Ruby object that wraps it is garbage collected, or when a call on the
+     * task fails with a communication error. It is only accessed with the GVL
+     * held
+     */
+    typedef std::map<std::string, RTaskContext*> InternedTaskContexts;
+    InternedTaskContexts interned_task_contexts;
+}
+
+void runkit::forget_interned_task_context(RTaskContext* context)
+{
+    if (context->interned_ior.empty())
+        return;
+
+    InternedTaskContexts::iterator it = interned_task_contexts.find(context->interned_ior);
+    if (it != interned_task_contexts.end() && it->second == context)
+        interned_task_contexts.erase(it);
+    context->interned_ior.clear();
+}
+
+void runkit::clear_interned_task_contexts()
+{
+    for (InternedTaskContexts::iterator it = interned_task_contexts.begin();
+         it != interned_task_contexts.end();
+         ++it)
+        it->second->interned_ior.clear();
+    interned_task_contexts.clear();
+}
+
+void runkit::task_call_failed(RTaskContext* context, VALUE exception_class)
+{
+    if (exception_class == eCORBAComError)
+        forget_interned_task_context(context);
+}
+
+namespace {
+    void release_task_context(RTaskContext* context)
+    {
+        if (--context->ruby_refs)
+            return;
+        forget_interned_task_context(context);
+        delete context;
+    }
+
+    /** Returns the RTaskContext for the given IOR, creating it only if there
+     * is none in the intern table
+     *
+     * The collocated task is looked up only when the object is created, so
+     * that changing the collocation setting affects only the new proxies.
+     * An interned object whose collocated task does not match the current
+     * setting is therefore replaced by a new one
+     */
+    RTaskContext* resolve_task_context(std::string const& ior)
+    {
+        CollocatedTaskPtr collocated = find_collocated_task(ior);
+        InternedTaskContexts::iterator it = interned_task_contexts.find(ior);
+        if (it != interned_task_contexts.end()) {
+            if (it->second->collocated == collocated)
+                return it->second;
+            forget_interned_task_context(it->second);
+        }
+
+        RTaskContext* context = corba_blocking_fct_call_with_result(
+            boost::bind(&CorbaAccess::createRTaskContext, CorbaAccess::instance(), ior));
+
+        // Another thread may have resolved the same IOR while the GVL was
+        // released
+        it = interned_task_contexts.find(ior);
+        if (it != interned_task_contexts.end()) {
+            delete context;
+            return it->second;
+        }
+        context->collocated = collocated;
+        context->interned_ior = ior;
+        interned_task_contexts[ior] = context;
+        return context;
+    }
+}
+
 /**
  * @!method TaskContext.new(ior, name:, model:)
+ *
+ * The task contexts created for the same IOR share the same underlying
+ * object, so only the first one costs remote calls
  */
 VALUE runkit::task_context_create(int argc, VALUE* argv, VALUE klass)
 {
@@ -141,9 +233,10 @@ VALUE runkit::task_context_create(int argc, VALUE* argv, VALUE klass)
     rb_scan_args(argc, argv, "1:", &ior_rb, &kw);
     std::string ior(StringValueCStr(ior_rb));
 
-    RTaskContext* context = corba_blocking_fct_call_with_result(
-        boost::bind(&CorbaAccess::createRTaskContext, CorbaAccess::instance(), ior));
-    VALUE obj = simple_wrap(klass, context);
+    RTaskContext* context = resolve_task_context(ior);
+    ++context->ruby_refs;
+    VALUE obj = Data_Wrap_Struct(klass, 0, release_task_context, context);
+    rb_iv_set(obj, "@corba", corbaAccess);
 
     VALUE args[2] = {ior_rb, kw};
 
@@ -155,6 +248,30 @@ VALUE runkit::task_context_create(int argc, VALUE* argv, VALUE klass)
     return obj;
 }
 
+/** call-seq:
+ *     task.do_invalidate_proxy
+ *
+ * Removes this task context from the table of task contexts indexed by IOR,
+ * so that the next TaskContext.new for its IOR resolves it again. It is
+ * called when a call on the task fails with a communication error
+ */
+static VALUE task_context_invalidate_proxy(VALUE self)
+{
+    forget_interned_task_context(&get_wrapped<RTaskContext>(self));
+    return Qnil;
+}
+
+/** call-seq:
+ *     Runkit::CORBA.interned_task_context_count => count
+ *
+ * The number of task contexts currently in the table of task contexts
+ * indexed by IOR
+ */
+static VALUE interned_task_context_count(VALUE mod)
+{
+    return SIZET2NUM(interned_task_contexts.size());
+}
+
 static VALUE task_context_equal_p(VALUE self, VALUE other)
 {
     if (!rb_obj_is_kind_of(other, cTaskContext))
@@ -174,9 +291,10 @@ static VALUE task_context_equal_p(VALUE self, VALUE other)
 static VALUE task_context_has_port_p(VALUE self, VALUE name)
 {
     RTaskContext& context = get_wrapped<RTaskContext>(self);
-    corba_blocking_fct_call(bind(&_objref_CDataFlowInterface::getPortType,
-        (CDataFlowInterface_ptr)context.ports,
-        StringValuePtr(name)));
+    task_blocking_fct_call(context,
+        bind(&_objref_CDataFlowInterface::getPortType,
+            (CDataFlowInterface_ptr)context.ports,
+            StringValuePtr(name)));
     return Qtrue;
 }
 
@@ -189,9 +307,10 @@ static VALUE task_context_real_name(VALUE self)
 static VALUE task_context_has_operation_p(VALUE self, VALUE name)
 {
     RTaskContext& context = get_wrapped<RTaskContext>(self);
-    corba_blocking_fct_call(bind(&_objref_COperationInterface::getResultType,
-        (_objref_COperationInterface*)context.main_service,
-        StringValuePtr(name)));
+    task_blocking_fct_call(context,
+        bind(&_objref_COperationInterface::getResultType,
+            (_objref_COperationInterface*)context.main_service,
+            StringValuePtr(name)));
     return Qtrue;
 }
 
@@ -199,7 +318,7 @@ static VALUE task_context_attribute_type_name(VALUE self, VALUE name)
 {
     RTaskContext& context = get_wrapped<RTaskContext>(self);
     std::string const expected_name = StringValuePtr(name);
-    CORBA::String_var attribute_type_name = corba_blocking_fct_call_with_result(
+    CORBA::String_var attribute_type_name = task_blocking_fct_call_with_result(context,
         bind(&_objref_CConfigurationInterface::getAttributeTypeName,
             (_objref_CConfigurationInterface*)context.main_service,
             StringValuePtr(name)));
@@ -215,7 +334,7 @@ static VALUE task_context_property_type_name(VALUE self, VALUE name)
 {
     RTaskContext& context = get_wrapped<RTaskContext>(self);
     std::string const expected_name = StringValuePtr(name);
-    CORBA::String_var attribute_type_name = corba_blocking_fct_call_with_result(
+    CORBA::String_var attribute_type_name = task_blocking_fct_call_with_result(context,
         bind(&_objref_CConfigurationInterface::getPropertyTypeName,
             (_objref_CConfigurationInterface*)context.main_service,
             StringValuePtr(name)));
@@ -233,7 +352,7 @@ static VALUE task_context_property_names(VALUE self)
 
     VALUE result = rb_ary_new();
     RTT::corba::CConfigurationInterface::CPropertyNames_var names =
-        corba_blocking_fct_call_with_result(
+        task_blocking_fct_call_with_result(context,
             bind(&_objref_CConfigurationInterface::getPropertyList,
                 (_objref_CConfigurationInterface*)context.main_service));
     for (unsigned int i = 0; i != names->length(); ++i) {
@@ -249,7 +368,7 @@ static VALUE task_context_attribute_names(VALUE self)
 
     VALUE result = rb_ary_new();
     RTT::corba::CConfigurationInterface::CAttributeNames_var names =
-        corba_blocking_fct_call_with_result(
+        task_blocking_fct_call_with_result(context,
             bind(&_objref_CConfigurationInterface::getAttributeList,
                 (_objref_CConfigurationInterface*)context.main_service));
     for (unsigned int i = 0; i != names->length(); ++i) {
@@ -270,12 +389,12 @@ static VALUE task_context_operation_names(VALUE self)
     VALUE result = rb_ary_new();
 #if RTT_VERSION_GTE(2, 8, 99)
     RTT::corba::COperationInterface::COperationDescriptions_var names =
-        corba_blocking_fct_call_with_result(
+        task_blocking_fct_call_with_result(context,
             bind(&_objref_COperationInterface::getOperations,
                 (_objref_COperationInterface*)context.main_service));
 #else
     RTT::corba::COperationInterface::COperationList_var names =
-        corba_blocking_fct_call_with_result(
+        task_blocking_fct_call_with_result(context,
             bind(&_objref_COperationInterface::getOperations,
                 (_objref_COperationInterface*)context.main_service));
 #endif
@@ -302,19 +421,229 @@ static VALUE task_context_read_port_info(VALUE self, VALUE name)
     RTT::corba::CPortType port_type;
     CORBA::String_var type_name;
     port_type =
-        corba_blocking_fct_call_with_result(bind(&_objref_CDataFlowInterface::getPortType,
-            (_objref_CDataFlowInterface*)context.ports,
-            StringValuePtr(name)));
+        task_blocking_fct_call_with_result(context,
+            bind(&_objref_CDataFlowInterface::getPortType,
+                (_objref_CDataFlowInterface*)context.ports,
+                StringValuePtr(name)));
     type_name =
-        corba_blocking_fct_call_with_result(bind(&_objref_CDataFlowInterface::getDataType,
-            (_objref_CDataFlowInterface*)context.ports,
-            StringValuePtr(name)));
+        task_blocking_fct_call_with_result(context,
+            bind(&_objref_CDataFlowInterface::getDataType,
+                (_objref_CDataFlowInterface*)context.ports,
+                StringValuePtr(name)));
 
     return rb_ary_new_from_args(2,
         port_type == RTT::corba::COutput,
         rb_str_new2(type_name));
 }
 
+namespace {
+    /** Whole interface of a remote task, as gathered by do_introspect */
+    struct TaskInterfaceSnapshot {
+        struct Port {
+            std::string name;
+            bool output;
+            std::string type_name;
+        };
+        struct Named {
+            std::string name;
+            std::string type_name;
+        };
+
+        std::vector<Port> ports;
+        std::vector<Named> properties;
+        std::vector<Named> attributes;
+        std::vector<std::string> operations;
+    };
+
+    /** Maximum number of threads do_introspect uses to issue its calls
+     *
+     * It is an upper bound, clamped to the size of the worker pool + 1 (see
+     * ParallelCalls)
+     */
+    static const size_t MAX_INTROSPECTION_THREADS = 8;
+
+    struct TaskIntrospection {
+        RTaskContext& context;
+        TaskInterfaceSnapshot snapshot;
+
+        TaskIntrospection(RTaskContext& context)
+            : context(context)
+        {
+        }
+
+        _objref_CConfigurationInterface* configuration()
+        {
+            return (_objref_CConfigurationInterface*)context.main_service;
+        }
+
+        void readPorts()
+        {
+            RTT::corba::CDataFlowInterface::CPortDescriptions_var ports =
+                context.ports->getPortDescriptions();
+            snapshot.ports.resize(ports->length());
+            for (unsigned int i = 0; i < ports->length(); ++i) {
+                TaskInterfaceSnapshot::Port& port = snapshot.ports[i];
+                port.name = ports[i].name.in();
+                port.output = (ports[i].type == RTT::corba::COutput);
+                port.type_name = ports[i].type_name.in();
+            }
+        }
+
+        void readPropertyNames()
+        {
+            RTT::corba::CConfigurationInterface::CPropertyNames_var names =
+                configuration()->getPropertyList();
+            snapshot.properties.resize(names->length());
+            for (unsigned int i = 0; i < names->length(); ++i)
+                snapshot.properties[i].name = names[i].name.in();
+        }
+
+        void readAttributeNames()
+        {
+            RTT::corba::CConfigurationInterface::CAttributeNames_var names =
+                configuration()->getAttributeList();
+            snapshot.attributes.resize(names->length());
+            for (unsigned int i = 0; i < names->length(); ++i) {
+#if RTT_VERSION_GTE(2, 8, 99)
+                snapshot.attributes[i].name = names[i].name.in();
+#else
+                snapshot.attributes[i].name = names[i].in();
+#endif
+            }
+        }
+
+        void readOperationNames()
+        {
+#if RTT_VERSION_GTE(2, 8, 99)
+            RTT::corba::COperationInterface::COperationDescriptions_var names =
+                ((_objref_COperationInterface*)context.main_service)->getOperations();
+#else
+            RTT::corba::COperationInterface::COperationList_var names =
+                ((_objref_COperationInterface*)context.main_service)->getOperations();
+#endif
+            snapshot.operations.resize(names->length());
+            for (unsigned int i = 0; i < names->length(); ++i) {
+#if RTT_VERSION_GTE(2, 8, 99)
+                snapshot.operations[i] = names[i].name.in();
+#else
+                snapshot.operations[i] = names[i].in();
+#endif
+            }
+        }
+
+        /** First pass: get the lists of interface objects */
+        void readLists(size_t i)
+        {
+            switch (i) {
+                case 0:
+                    return readPorts();
+                case 1:
+                    return readPropertyNames();
+                case 2:
+                    return readAttributeNames();
+                case 3:
+                    return readOperationNames();
+            }
+        }
+
+        /** Second pass: get the property and attribute types, the first
+         * properties.size() indexes being the properties
+         */
+        void readTypeName(size_t i)
+        {
+            size_t property_count = snapshot.properties.size();
+            if (i < property_count) {
+                TaskInterfaceSnapshot::Named& property = snapshot.properties[i];
+                CORBA::String_var type_name =
+                    configuration()->getPropertyTypeName(property.name.c_str());
+                property.type_name = type_name.in();
+            }
+            else {
+                TaskInterfaceSnapshot::Named& attribute =
+                    snapshot.attributes[i - property_count];
+                CORBA::String_var type_name =
+                    configuration()->getAttributeTypeName(attribute.name.c_str());
+                attribute.type_name = type_name.in();
+            }
+        }
+
+        TaskInterfaceSnapshot run()
+        {
+            ParallelCalls(4,
+                boost::bind(&TaskIntrospection::readLists, this, _1),
+                MAX_INTROSPECTION_THREADS)
+                .run();
+            ParallelCalls(snapshot.properties.size() + snapshot.attributes.size(),
+                boost::bind(&TaskIntrospection::readTypeName, this, _1),
+                MAX_INTROSPECTION_THREADS)
+                .run();
+            return snapshot;
+        }
+    };
+
+    TaskInterfaceSnapshot introspect_task(RTaskContext* context)
+    {
+        TaskIntrospection introspection(*context);
+        return introspection.run();
+    }
+
+    VALUE named_to_ruby(std::vector<TaskInterfaceSnapshot::Named> const& objects)
+    {
+        VALUE result = rb_ary_new_capa(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i) {
+            rb_ary_push(result,
+                rb_ary_new_from_args(2,
+                    rb_str_new2(objects[i].name.c_str()),
+                    rb_str_new2(objects[i].type_name.c_str())));
+        }
+        return result;
+    }
+}
+
+/**
+ * @!method do_introspect
+ *   Reads the whole interface of the task with the GVL released only once
+ *
+ *   The calls to the remote task are made in parallel. On a remote host, this
+ *   takes two round trips regardless of the size of the interface, instead of
+ *   one or two per interface object.
+ *
+ *   @return [Hash] with the :ports ([name, is_output, type_name] tuples),
+ *     :properties and :attributes ([name, type_name] tuples) and
+ *     :operations (names) keys
+ */
+static VALUE task_context_introspect(VALUE self)
+{
+    RTaskContext& context = get_wrapped<RTaskContext>(self);
+    TaskInterfaceSnapshot snapshot =
+        task_blocking_fct_call_with_result(context,
+            boost::bind(&introspect_task, &context));
+
+    VALUE ports = rb_ary_new_capa(snapshot.ports.size());
+    for (size_t i = 0; i < snapshot.ports.size(); ++i) {
+        TaskInterfaceSnapshot::Port const& port = snapshot.ports[i];
+        rb_ary_push(ports,
+            rb_ary_new_from_args(3,
+                rb_str_new2(port.name.c_str()),
+                port.output ? Qtrue : Qfalse,
+                rb_str_new2(port.type_name.c_str())));
+    }
+    VALUE operations = rb_ary_new_capa(snapshot.operations.size());
+    for (size_t i = 0; i < snapshot.operations.size(); ++i)
+        rb_ary_push(operations, rb_str_new2(snapshot.operations[i].c_str()));
+
+    VALUE result = rb_hash_new();
+    rb_hash_aset(result, ID2SYM(rb_intern("ports")), ports);
+    rb_hash_aset(result,
+        ID2SYM(rb_intern("properties")),
+        named_to_ruby(snapshot.properties));
+    rb_hash_aset(result,
+        ID2SYM(rb_intern("attributes")),
+        named_to_ruby(snapshot.attributes));
+    rb_hash_aset(result, ID2SYM(rb_intern("operations")), operations);
+    return result;
+}
+
 static VALUE registered_type_p(VALUE mod, VALUE type_name)
 {
     RTT::types::TypeInfo* ti =
@@ -347,8 +676,9 @@ static VALUE task_context_port_names(VALUE self)
     VALUE result = rb_ary_new();
     RTaskContext& context = get_wrapped<RTaskContext>(self);
     RTT::corba::CDataFlowInterface::CPortNames_var ports =
-        corba_blocking_fct_call_with_result(bind(&_objref_CDataFlowInterface::getPorts,
-            (_objref_CDataFlowInterface*)context.ports));
+        task_blocking_fct_call_with_result(context,
+            bind(&_objref_CDataFlowInterface::getPorts,
+                (_objref_CDataFlowInterface*)context.ports));
 
     for (unsigned int i = 0; i < ports->length(); ++i)
         rb_ary_push(result, rb_str_new2(ports[i]));
@@ -373,18 +703,93 @@ static VALUE task_context_port_names(VALUE self)
 static VALUE task_context_state(VALUE task)
 {
     RTaskContext& context = get_wrapped<RTaskContext>(task);
-    return INT2FIX(corba_blocking_fct_call_with_result(
+    if (RTT::TaskContext* local = context.collocatedTask())
+        return INT2FIX(local->getTaskState());
+
+    return INT2FIX(task_blocking_fct_call_with_result(context,
         boost::bind(&_objref_CTaskContext::getTaskState,
             (CTaskContext_ptr)context.task)));
 }
 
+namespace {
+    struct StateCall : public AsyncCall {
+        RTT::corba::CTaskContext_var task;
+        RTT::corba::CTaskState state;
+
+        StateCall(RTT::corba::CTaskContext_ptr task)
+            : task(RTT::corba::CTaskContext::_duplicate(task))
+        {
+        }
+
+        void run()
+        {
+            state = task->getTaskState();
+        }
+
+        VALUE toRuby()
+        {
+            return INT2FIX(state);
+        }
+    };
+}
+
+// call-seq:
+//  task.do_state_async => async_call
+//
+// Asynchronous version of #do_state. The returned Runkit::AsyncCall's value
+// is the state as an integer
+static VALUE task_context_state_async(VALUE task)
+{
+    RTaskContext& context = get_wrapped<RTaskContext>(task);
+    boost::shared_ptr<AsyncCall> call(new StateCall(context.task.in()));
+    call->setTask(task);
+    return async_call_start(call);
+}
+
+/** Maximum number of threads Runkit.do_states_of uses to issue its calls
+ *
+ * It is an upper bound, clamped to Runkit::CORBA.async_worker_count + 1 (see
+ * ParallelCalls)
+ */
+static const size_t MAX_STATE_QUERY_THREADS = 32;
+
+/** call-seq:
+ *     Runkit.do_states_of(tasks) => states
+ *
+ * Reads the state of all the given tasks with the GVL released only once.
+ * The calls are made in parallel.
+ *
+ * Returns an array with, for each task, either its state as an integer or
+ * the exception raised while reading it
+ */
+static VALUE states_of(VALUE mod, VALUE tasks)
+{
+    tasks = rb_Array(tasks);
+    long count = RARRAY_LEN(tasks);
+    for (long i = 0; i < count; ++i) {
+        if (!rb_obj_is_kind_of(rb_ary_entry(tasks, i), cTaskContext))
+            rb_raise(rb_eArgError, "expected an array of Runkit::TaskContext");
+    }
+
+    AsyncCalls calls;
+    calls.reserve(count);
+    for (long i = 0; i < count; ++i) {
+        VALUE task = rb_ary_entry(tasks, i);
+        RTaskContext& context = get_wrapped<RTaskContext>(task);
+        calls.push_back(
+            boost::shared_ptr<AsyncCall>(new StateCall(context.task.in())));
+        calls.back()->setTask(task);
+    }
+    return async_calls_execute(calls, MAX_STATE_QUERY_THREADS);
+}
+
 static VALUE call_checked_state_change(VALUE task,
     char const* msg,
     bool (RTT::corba::_objref_CTaskContext::*m)())
 {
     RTaskContext& context = get_wrapped<RTaskContext>(task);
     RTT::corba::_objref_CTaskContext& obj = *context.task;
-    if (!(corba_blocking_fct_call_with_result(boost::bind(m, &obj))))
+    if (!(task_blocking_fct_call_with_result(context, boost::bind(m, &obj))))
         rb_raise(eStateTransitionFailed, "%s", msg);
     return Qnil;
 }
@@ -429,6 +834,19 @@ static VALUE task_context_reset_exception(VALUE task)
         &RTT::corba::_objref_CTaskContext::resetException);
 }
 
+namespace {
+    /** Returns the given port if its task lives in this process, and NULL
+     * otherwise. Must be called with the GVL held
+     */
+    RTT::base::PortInterface* collocated_port(RTaskContext& task, VALUE name)
+    {
+        RTT::TaskContext* local = task.collocatedTask();
+        if (!local)
+            return 0;
+        return local->ports()->getPort(StringValuePtr(name));
+    }
+}
+
 /* call-seq:
  *  port.connected? => true or false
  *
@@ -439,28 +857,61 @@ static VALUE port_connected_p(VALUE self)
     RTaskContext* task;
     VALUE name;
     tie(task, tuples::ignore, name) = get_port_reference(self);
+    if (RTT::base::PortInterface* local = collocated_port(*task, name))
+        return local->connected() ? Qtrue : Qfalse;
+
     bool result =
-        corba_blocking_fct_call_with_result(bind(&_objref_CDataFlowInterface::isConnected,
-            (_objref_CDataFlowInterface*)task->ports,
-            StringValuePtr(name)));
+        task_blocking_fct_call_with_result(*task,
+            bind(&_objref_CDataFlowInterface::isConnected,
+                (_objref_CDataFlowInterface*)task->ports,
+                StringValuePtr(name)));
     return result ? Qtrue : Qfalse;
 }
 
+/** Raises if the given policy hash is not valid
+ *
+ * It does not create any C++ object, so that the batched connection calls
+ * can validate all their policies before building their state
+ */
+static void checkPolicyHash(VALUE options)
+{
+    Check_Type(options, T_HASH);
+    VALUE conn_type = rb_hash_aref(options, ID2SYM(rb_intern("type")));
+    if (!SYMBOL_P(conn_type) || (SYM2ID(conn_type) != rb_intern("data") &&
+                                    SYM2ID(conn_type) != rb_intern("buffer") &&
+                                    SYM2ID(conn_type) != rb_intern("circular_buffer"))) {
+        VALUE obj_as_str = rb_funcall(conn_type, rb_intern("inspect"), 0);
+        rb_raise(rb_eArgError, "invalid connection type %s", StringValuePtr(obj_as_str));
+    }
+
+    NUM2INT(rb_hash_aref(options, ID2SYM(rb_intern("transport"))));
+    NUM2INT(rb_hash_aref(options, ID2SYM(rb_intern("data_size"))));
+    NUM2INT(rb_hash_aref(options, ID2SYM(rb_intern("size"))));
+    VALUE name_id = rb_hash_aref(options, ID2SYM(rb_intern("name_id")));
+    StringValuePtr(name_id);
+
+    VALUE lock_type = rb_hash_aref(options, ID2SYM(rb_intern("lock")));
+    if (!SYMBOL_P(lock_type) || (SYM2ID(lock_type) != rb_intern("locked") &&
+                                    SYM2ID(lock_type) != rb_intern("lock_free") &&
+                                    SYM2ID(lock_type) != rb_intern("unsync"))) {
+        VALUE obj_as_str = rb_funcall(lock_type, rb_intern("to_s"), 0);
+        rb_raise(rb_eArgError, "invalid locking type %s", StringValuePtr(obj_as_str));
+    }
+}
+
 static RTT::corba::CConnPolicy policyFromHash(VALUE options)
 {
+    // Raise before the policy gets created
+    checkPolicyHash(options);
+
     RTT::corba::CConnPolicy result = toCORBA(RTT::ConnPolicy());
-    VALUE conn_type_value = rb_hash_aref(options, ID2SYM(rb_intern("type")));
-    VALUE conn_type = SYM2ID(conn_type_value);
+    VALUE conn_type = SYM2ID(rb_hash_aref(options, ID2SYM(rb_intern("type"))));
     if (conn_type == rb_intern("data"))
         result.type = RTT::corba::CData;
     else if (conn_type == rb_intern("buffer"))
         result.type = RTT::corba::CBuffer;
-    else if (conn_type == rb_intern("circular_buffer"))
+    else
         result.type = RTT::corba::CCircularBuffer;
-    else {
-        VALUE obj_as_str = rb_funcall(conn_type_value, rb_intern("inspect"), 0);
-        rb_raise(rb_eArgError, "invalid connection type %s", StringValuePtr(obj_as_str));
-    }
 
     result.transport = NUM2INT(rb_hash_aref(options, ID2SYM(rb_intern("transport"))));
     result.data_size = NUM2INT(rb_hash_aref(options, ID2SYM(rb_intern("data_size"))));
@@ -475,12 +926,8 @@ static RTT::corba::CConnPolicy policyFromHash(VALUE options)
         result.lock_policy = RTT::corba::CLocked;
     else if (lock_type == rb_intern("lock_free"))
         result.lock_policy = RTT::corba::CLockFree;
-    else if (lock_type == rb_intern("unsync"))
+    else
         result.lock_policy = RTT::corba::CUnsync;
-    else {
-        VALUE obj_as_str = rb_funcall(lock_type, rb_intern("to_s"), 0);
-        rb_raise(rb_eArgError, "invalid locking type %s", StringValuePtr(obj_as_str));
-    }
     return result;
 }
 
@@ -497,7 +944,20 @@ static VALUE do_port_connect_to(VALUE routput_port, VALUE rinput_port, VALUE opt
     tie(in_task, tuples::ignore, in_name) = get_port_reference(rinput_port);
 
     RTT::corba::CConnPolicy policy = policyFromHash(options);
-    bool result = corba_blocking_fct_call_with_result(
+
+    // Connect ports of this process directly, so that the samples do not go
+    // through CORBA
+    RTT::base::OutputPortInterface* local_out =
+        dynamic_cast<RTT::base::OutputPortInterface*>(collocated_port(*out_task, out_name));
+    RTT::base::InputPortInterface* local_in =
+        dynamic_cast<RTT::base::InputPortInterface*>(collocated_port(*in_task, in_name));
+    if (local_out && local_in && policy.transport == 0) {
+        if (!local_out->connectTo(local_in, toRTT(policy)))
+            rb_raise(eConnectionFailed, "failed to connect ports");
+        return Qnil;
+    }
+
+    bool result = task_blocking_fct_call_with_result(*out_task,
         bind(&_objref_CDataFlowInterface::createConnection,
             (_objref_CDataFlowInterface*)out_task->ports,
             StringValuePtr(out_name),
@@ -514,9 +974,15 @@ static VALUE do_port_disconnect_all(VALUE port)
     RTaskContext* task;
     VALUE name;
     tie(task, tuples::ignore, name) = get_port_reference(port);
-    corba_blocking_fct_call(bind(&_objref_CDataFlowInterface::disconnectPort,
-        (_objref_CDataFlowInterface*)task->ports,
-        StringValuePtr(name)));
+    if (RTT::base::PortInterface* local = collocated_port(*task, name)) {
+        local->disconnect();
+        return Qnil;
+    }
+
+    task_blocking_fct_call(*task,
+        bind(&_objref_CDataFlowInterface::disconnectPort,
+            (_objref_CDataFlowInterface*)task->ports,
+            StringValuePtr(name)));
     return Qnil;
 }
 
@@ -528,7 +994,12 @@ static VALUE do_port_disconnect_from(VALUE self, VALUE other)
     RTaskContext* other_task;
     VALUE other_name;
     tie(other_task, tuples::ignore, other_name) = get_port_reference(other);
-    bool result = corba_blocking_fct_call_with_result(
+    RTT::base::PortInterface* local_self = collocated_port(*self_task, self_name);
+    RTT::base::PortInterface* local_other = collocated_port(*other_task, other_name);
+    if (local_self && local_other)
+        return local_self->disconnect(local_other) ? Qtrue : Qfalse;
+
+    bool result = task_blocking_fct_call_with_result(*self_task,
         bind(&_objref_CDataFlowInterface::removeConnection,
             (_objref_CDataFlowInterface*)self_task->ports,
             StringValuePtr(self_name),
@@ -537,6 +1008,336 @@ static VALUE do_port_disconnect_from(VALUE self, VALUE other)
     return result ? Qtrue : Qfalse;
 }
 
+/** Maximum number of threads used by the batched connection calls
+ *
+ * It is an upper bound, clamped to Runkit::CORBA.async_worker_count + 1 (see
+ * ParallelCalls)
+ */
+static const size_t MAX_CONNECTION_THREADS = 32;
+/** Maximum number of batched connection calls made concurrently on the same
+ * task */
+static const size_t MAX_CONNECTION_CALLS_PER_TASK = 4;
+
+namespace {
+    struct ConnectCall : public AsyncCall {
+        RTT::corba::CDataFlowInterface_var out_ports;
+        std::string out_name;
+        RTT::corba::CDataFlowInterface_var in_ports;
+        std::string in_name;
+        RTT::corba::CConnPolicy policy;
+        bool result;
+
+        ConnectCall(RTaskContext& out_task,
+            std::string const& out_name,
+            RTaskContext& in_task,
+            std::string const& in_name,
+            RTT::corba::CConnPolicy const& policy)
+            : out_ports(RTT::corba::CDataFlowInterface::_duplicate(out_task.ports))
+            , out_name(out_name)
+            , in_ports(RTT::corba::CDataFlowInterface::_duplicate(in_task.ports))
+            , in_name(in_name)
+            , policy(policy)
+            , result(false)
+        {
+        }
+
+        void run()
+        {
+            result = out_ports->createConnection(out_name.c_str(),
+                in_ports.in(),
+                in_name.c_str(),
+                policy);
+        }
+
+        VALUE toRuby()
+        {
+            return result ? Qtrue : Qfalse;
+        }
+    };
+
+    struct DisconnectCall : public AsyncCall {
+        RTT::corba::CDataFlowInterface_var ports;
+        std::string name;
+        RTT::corba::CDataFlowInterface_var other_ports;
+        std::string other_name;
+        bool result;
+
+        DisconnectCall(RTaskContext& task,
+            std::string const& name,
+            RTaskContext& other_task,
+            std::string const& other_name)
+            : ports(RTT::corba::CDataFlowInterface::_duplicate(task.ports))
+            , name(name)
+            , other_ports(RTT::corba::CDataFlowInterface::_duplicate(other_task.ports))
+            , other_name(other_name)
+            , result(false)
+        {
+        }
+
+        void run()
+        {
+            result = ports->removeConnection(name.c_str(),
+                other_ports.in(),
+                other_name.c_str());
+        }
+
+        VALUE toRuby()
+        {
+            return result ? Qtrue : Qfalse;
+        }
+    };
+
+    struct DisconnectAllCall : public AsyncCall {
+        RTT::corba::CDataFlowInterface_var ports;
+        std::string name;
+
+        DisconnectAllCall(RTaskContext& task, std::string const& name)
+            : ports(RTT::corba::CDataFlowInterface::_duplicate(task.ports))
+            , name(name)
+        {
+        }
+
+        void run()
+        {
+            ports->disconnectPort(name.c_str());
+        }
+
+        VALUE toRuby()
+        {
+            return Qtrue;
+        }
+    };
+
+    struct ConnectedCall : public AsyncCall {
+        RTT::corba::CDataFlowInterface_var ports;
+        std::string name;
+        bool result;
+
+        ConnectedCall(RTaskContext& task, std::string const& name)
+            : ports(RTT::corba::CDataFlowInterface::_duplicate(task.ports))
+            , name(name)
+            , result(false)
+        {
+        }
+
+        void run()
+        {
+            result = ports->isConnected(name.c_str());
+        }
+
+        VALUE toRuby()
+        {
+            return result ? Qtrue : Qfalse;
+        }
+    };
+
+    /** Assigns the batched connection calls to lanes, so that at most
+     * MAX_CONNECTION_CALLS_PER_TASK calls are made concurrently on the same
+     * task
+     */
+    class TaskLanes {
+        // First lane and number of calls of each task
+        std::map<RTaskContext const*, std::pair<size_t, size_t>> tasks;
+
+    public:
+        std::vector<size_t> lanes;
+
+        void add(RTaskContext const* task)
+        {
+            std::map<RTaskContext const*, std::pair<size_t, size_t>>::iterator it =
+                tasks.find(task);
+            if (it == tasks.end()) {
+                size_t first_lane = tasks.size() * MAX_CONNECTION_CALLS_PER_TASK;
+                it = tasks.insert(std::make_pair(task, std::make_pair(first_lane, 0)))
+                         .first;
+            }
+            lanes.push_back(
+                it->second.first + it->second.second % MAX_CONNECTION_CALLS_PER_TASK);
+            ++it->second.second;
+        }
+    };
+
+    RTaskContext& get_port_task(VALUE port, std::string& name)
+    {
+        RTaskContext* task;
+        VALUE rb_name;
+        tie(task, tuples::ignore, rb_name) = get_port_reference(port);
+        name = StringValuePtr(rb_name);
+        return *task;
+    }
+
+    /** Raises if get_port_task would raise on the given port
+     *
+     * The batched calls validate all their arguments with the check_*
+     * functions before building their C++ state, which must not be
+     * skipped by a Ruby exception
+     */
+    void check_port(VALUE port)
+    {
+        VALUE rb_name = get_port_reference(port).get<2>();
+        StringValuePtr(rb_name);
+    }
+
+    /** Raises if the given edge is not an array of the given size, made of
+     * ports followed by extra elements
+     */
+    void check_edge(VALUE edge, long size, long port_count)
+    {
+        Check_Type(edge, T_ARRAY);
+        if (RARRAY_LEN(edge) != size)
+            rb_raise(rb_eArgError,
+                "expected an array of %ld elements, got %ld",
+                size,
+                RARRAY_LEN(edge));
+        for (long i = 0; i < port_count; ++i)
+            check_port(rb_ary_entry(edge, i));
+    }
+}
+
+/** call-seq:
+ *     Runkit.do_connect_all([[output_port, input_port, policy], ...]) => results
+ *
+ * Creates many connections with the GVL released only once. Each distinct
+ * policy hash is converted only once. The calls are made in parallel, with
+ * at most MAX_CONNECTION_CALLS_PER_TASK concurrent calls on the same output
+ * task.
+ *
+ * Returns an array with, for each connection, either true, false if the
+ * connection could not be created, or the exception raised while creating it
+ */
+static VALUE do_connect_all(VALUE mod, VALUE edges)
+{
+    Check_Type(edges, T_ARRAY);
+    long count = RARRAY_LEN(edges);
+
+    // Validate everything first, and assign the distinct policies their
+    // index in the policies vector
+    VALUE policy_indexes = rb_hash_new();
+    long policy_count = 0;
+    for (long i = 0; i < count; ++i) {
+        VALUE edge = rb_ary_entry(edges, i);
+        check_edge(edge, 3, 2);
+        VALUE rb_policy = rb_ary_entry(edge, 2);
+        if (NIL_P(rb_hash_lookup2(policy_indexes, rb_policy, Qnil))) {
+            checkPolicyHash(rb_policy);
+            rb_hash_aset(policy_indexes, rb_policy, LONG2NUM(policy_count++));
+        }
+    }
+
+    std::vector<RTT::corba::CConnPolicy> policies(policy_count);
+    std::vector<bool> converted(policy_count, false);
+    AsyncCalls calls;
+    TaskLanes lanes;
+    for (long i = 0; i < count; ++i) {
+        VALUE edge = rb_ary_entry(edges, i);
+        VALUE rb_policy = rb_ary_entry(edge, 2);
+        long policy_index = NUM2LONG(rb_hash_lookup2(policy_indexes, rb_policy, Qnil));
+        if (!converted[policy_index]) {
+            policies[policy_index] = policyFromHash(rb_policy);
+            converted[policy_index] = true;
+        }
+
+        std::string out_name;
+        RTaskContext& out_task = get_port_task(rb_ary_entry(edge, 0), out_name);
+        std::string in_name;
+        RTaskContext& in_task = get_port_task(rb_ary_entry(edge, 1), in_name);
+        calls.push_back(boost::shared_ptr<AsyncCall>(new ConnectCall(out_task,
+            out_name,
+            in_task,
+            in_name,
+            policies[policy_index])));
+        calls.back()->setTask(rb_iv_get(rb_ary_entry(edge, 0), "@task"));
+        lanes.add(&out_task);
+    }
+    RB_GC_GUARD(policy_indexes);
+    return async_calls_execute(calls, lanes.lanes, MAX_CONNECTION_THREADS);
+}
+
+/** call-seq:
+ *     Runkit.do_disconnect_all([[port, other_port], ...]) => results
+ *
+ * Batched version of Port#do_disconnect_from
+ *
+ * Returns an array with, for each pair, either true, false if the ports were
+ * not connected, or the exception raised while disconnecting them
+ */
+static VALUE do_disconnect_all(VALUE mod, VALUE edges)
+{
+    Check_Type(edges, T_ARRAY);
+    long count = RARRAY_LEN(edges);
+    for (long i = 0; i < count; ++i)
+        check_edge(rb_ary_entry(edges, i), 2, 2);
+
+    AsyncCalls calls;
+    TaskLanes lanes;
+    for (long i = 0; i < count; ++i) {
+        VALUE edge = rb_ary_entry(edges, i);
+        std::string name;
+        RTaskContext& task = get_port_task(rb_ary_entry(edge, 0), name);
+        std::string other_name;
+        RTaskContext& other_task = get_port_task(rb_ary_entry(edge, 1), other_name);
+        calls.push_back(boost::shared_ptr<AsyncCall>(
+            new DisconnectCall(task, name, other_task, other_name)));
+        calls.back()->setTask(rb_iv_get(rb_ary_entry(edge, 0), "@task"));
+        lanes.add(&task);
+    }
+    return async_calls_execute(calls, lanes.lanes, MAX_CONNECTION_THREADS);
+}
+
+/** call-seq:
+ *     Runkit.do_disconnect_ports(ports) => results
+ *
+ * Batched version of Port#do_disconnect_all
+ *
+ * Returns an array with, for each port, either true or the exception raised
+ * while disconnecting it
+ */
+static VALUE do_disconnect_ports(VALUE mod, VALUE ports)
+{
+    Check_Type(ports, T_ARRAY);
+    long count = RARRAY_LEN(ports);
+    for (long i = 0; i < count; ++i)
+        check_port(rb_ary_entry(ports, i));
+
+    AsyncCalls calls;
+    TaskLanes lanes;
+    for (long i = 0; i < count; ++i) {
+        std::string name;
+        RTaskContext& task = get_port_task(rb_ary_entry(ports, i), name);
+        calls.push_back(boost::shared_ptr<AsyncCall>(new DisconnectAllCall(task, name)));
+        calls.back()->setTask(rb_iv_get(rb_ary_entry(ports, i), "@task"));
+        lanes.add(&task);
+    }
+    return async_calls_execute(calls, lanes.lanes, MAX_CONNECTION_THREADS);
+}
+
+/** call-seq:
+ *     Runkit.do_connected_all(ports) => results
+ *
+ * Batched version of Port#connected?
+ *
+ * Returns an array with, for each port, either true or false or the exception
+ * raised while querying it
+ */
+static VALUE do_connected_all(VALUE mod, VALUE ports)
+{
+    Check_Type(ports, T_ARRAY);
+    long count = RARRAY_LEN(ports);
+    for (long i = 0; i < count; ++i)
+        check_port(rb_ary_entry(ports, i));
+
+    AsyncCalls calls;
+    TaskLanes lanes;
+    for (long i = 0; i < count; ++i) {
+        std::string name;
+        RTaskContext& task = get_port_task(rb_ary_entry(ports, i), name);
+        calls.push_back(boost::shared_ptr<AsyncCall>(new ConnectedCall(task, name)));
+        calls.back()->setTask(rb_iv_get(rb_ary_entry(ports, i), "@task"));
+        lanes.add(&task);
+    }
+    return async_calls_execute(calls, lanes.lanes, MAX_CONNECTION_THREADS);
+}
+
 static VALUE do_port_create_stream(VALUE rport, VALUE _policy)
 {
     RTaskContext* task;
@@ -544,7 +1345,7 @@ static VALUE do_port_create_stream(VALUE rport, VALUE _policy)
     tie(task, tuples::ignore, name) = get_port_reference(rport);
 
     RTT::corba::CConnPolicy policy = policyFromHash(_policy);
-    bool result = corba_blocking_fct_call_with_result(
+    bool result = task_blocking_fct_call_with_result(*task,
         bind(&_objref_CDataFlowInterface::createStream,
             (_objref_CDataFlowInterface*)task->ports,
             StringValuePtr(name),
@@ -560,10 +1361,11 @@ static VALUE do_port_remove_stream(VALUE rport, VALUE stream_name)
     VALUE name;
     tie(task, tuples::ignore, name) = get_port_reference(rport);
 
-    corba_blocking_fct_call(bind(&_objref_CDataFlowInterface::removeStream,
-        (_objref_CDataFlowInterface*)task->ports,
-        StringValuePtr(name),
-        StringValuePtr(stream_name)));
+    task_blocking_fct_call(*task,
+        bind(&_objref_CDataFlowInterface::removeStream,
+            (_objref_CDataFlowInterface*)task->ports,
+            StringValuePtr(name),
+            StringValuePtr(stream_name)));
     return Qnil;
 }
 
@@ -768,7 +1570,19 @@ extern "C" void Init_rtt_corba_ext()
         RUBY_METHOD_FUNC(task_context_real_name),
         0);
     rb_define_method(cTaskContext, "==", RUBY_METHOD_FUNC(task_context_equal_p), 1);
+    rb_define_method(cTaskContext,
+        "do_invalidate_proxy",
+        RUBY_METHOD_FUNC(task_context_invalidate_proxy),
+        0);
+    rb_define_singleton_method(mCORBA,
+        "interned_task_context_count",
+        RUBY_METHOD_FUNC(interned_task_context_count),
+        0);
     rb_define_method(cTaskContext, "do_state", RUBY_METHOD_FUNC(task_context_state), 0);
+    rb_define_method(cTaskContext,
+        "do_state_async",
+        RUBY_METHOD_FUNC(task_context_state_async),
+        0);
     rb_define_method(cTaskContext,
         "do_configure",
         RUBY_METHOD_FUNC(task_context_configure),
@@ -819,6 +1633,10 @@ extern "C" void Init_rtt_corba_ext()
         "do_port_names",
         RUBY_METHOD_FUNC(task_context_port_names),
         0);
+    rb_define_method(cTaskContext,
+        "do_introspect",
+        RUBY_METHOD_FUNC(task_context_introspect),
+        0);
 
     rb_define_method(cPort, "connected?", RUBY_METHOD_FUNC(port_connected_p), 0);
     rb_define_method(cPort,
@@ -842,8 +1660,33 @@ extern "C" void Init_rtt_corba_ext()
         RUBY_METHOD_FUNC(do_port_connect_to),
         2);
 
+    rb_define_singleton_method(mRoot,
+        "do_states_of",
+        RUBY_METHOD_FUNC(states_of),
+        1);
+    rb_define_singleton_method(mRoot,
+        "do_connect_all",
+        RUBY_METHOD_FUNC(do_connect_all),
+        1);
+    rb_define_singleton_method(mRoot,
+        "do_disconnect_all",
+        RUBY_METHOD_FUNC(do_disconnect_all),
+        1);
+    rb_define_singleton_method(mRoot,
+        "do_disconnect_ports",
+        RUBY_METHOD_FUNC(do_disconnect_ports),
+        1);
+    rb_define_singleton_method(mRoot,
+        "do_connected_all",
+        RUBY_METHOD_FUNC(do_connected_all),
+        1);
+
     rtt_corba_init_CORBA(mRoot, mCORBA, mNameServices);
     rtt_corba_init_data_handling(cTaskContext);
     rtt_corba_init_ruby_task_context(mRoot, cTaskContext, cOutputPort, cInputPort);
     rtt_corba_init_operations(mRoot, cTaskContext);
+    rtt_corba_init_handle_pool(mRoot);
+    rtt_corba_init_memory_view(mRoot);
+    rtt_corba_init_async_call(mRoot, mCORBA);
+    rtt_corba_init_name_service_watcher();
 }
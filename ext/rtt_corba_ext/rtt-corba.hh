@@ -103,6 +103,16 @@ namespace runkit {
     void rtt_corba_init_CORBA(VALUE mRoot, VALUE mCORBA, VALUE mNameServices);
     void rtt_corba_init_data_handling(VALUE cTaskContext);
     void rtt_corba_init_operations(VALUE mRoot, VALUE cTaskContext);
+    void rtt_corba_init_handle_pool(VALUE mRoot);
+    void rtt_corba_init_memory_view(VALUE mRoot);
+    void rtt_corba_init_async_call(VALUE mRoot, VALUE mCORBA);
+    void rtt_corba_init_name_service_watcher();
+
+    /** Stops and joins the threads of all the name service watchers
+     *
+     * It must be called before the ORB gets destroyed
+     */
+    void name_service_watchers_shutdown();
 }
 
 #endif
@@ -9,15 +9,29 @@
 
 #include <rtt/OutputPort.hpp>
 #include <rtt/base/InputPortInterface.hpp>
+#include <rtt/internal/Reference.hpp>
 
 #include <rtt/transports/corba/CorbaLib.hpp>
 #include <typelib_ruby.hh>
 
+#include "corba.hh"
+#include "handle_pool.hh"
 #include "rblocking_call.h"
 #include <rtt/TaskContext.hpp>
 #include <rtt/transports/corba/CorbaDispatcher.hpp>
 #include <rtt/transports/corba/TaskContextServer.hpp>
 
+#include <boost/thread/mutex.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <poll.h>
+#include <ruby/thread.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
 #ifdef HAS_GETTID
 #include <sys/syscall.h>
 #endif
@@ -30,6 +44,61 @@ static VALUE cLocalOutputPort;
 static VALUE cLocalInputPort;
 
 namespace {
+    /** Pipe used to notify Ruby that new data arrived on a local input port
+     *
+     * The write end is written to from the RTT side (i.e. the thread that
+     * writes the sample), the read end is exposed to Ruby
+     */
+    struct PortNotifier {
+        int read_fd;
+        int write_fd;
+    };
+    typedef std::map<RTT::base::PortInterface const*, PortNotifier> PortNotifiers;
+    PortNotifiers port_notifiers;
+    boost::mutex port_notifiers_mutex;
+
+    /** Signal the notifier of the given port, if there is one
+     *
+     * The notification is the arrival time of the sample, as a 64 bit
+     * CLOCK_MONOTONIC timestamp in nanoseconds
+     */
+    void signal_port_notifier(RTT::base::PortInterface const* port)
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t timestamp = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+
+        boost::mutex::scoped_lock lock(port_notifiers_mutex);
+        PortNotifiers::const_iterator it = port_notifiers.find(port);
+        if (it == port_notifiers.end())
+            return;
+
+        // The pipe is non-blocking. If it is full, Ruby has not yet processed
+        // the previous notifications, which is as good as this one. Writes
+        // smaller than PIPE_BUF are atomic, so the pipe never contains a
+        // partial timestamp
+        ssize_t ret = write(it->second.write_fd, &timestamp, sizeof(timestamp));
+        (void)ret;
+    }
+
+    /** Remove the notifier of the given port, if there is one, and close
+     * the write end of its pipe
+     *
+     * The read end is owned by the Ruby IO object that wraps it, which closes
+     * it. Closing it here would leave the IO with a file descriptor number
+     * that may get reused
+     */
+    void remove_port_notifier(RTT::base::PortInterface const* port)
+    {
+        boost::mutex::scoped_lock lock(port_notifiers_mutex);
+        PortNotifiers::iterator it = port_notifiers.find(port);
+        if (it == port_notifiers.end())
+            return;
+
+        close(it->second.write_fd);
+        port_notifiers.erase(it);
+    }
+
     struct LocalTaskContext : public RTT::TaskContext {
         std::string model_name;
 
@@ -76,6 +145,16 @@ namespace {
             _state.write(getTaskState());
         }
 
+        /** Called by RTT when new data arrives on a port that has
+         * notifications enabled
+         */
+        bool dataOnPortHook(RTT::base::PortInterface* port)
+        {
+            signal_port_notifier(port);
+            // Ruby reads the port on its own, there is nothing to trigger
+            return false;
+        }
+
         boost::int32_t __orogen_getTID() const
         {
             return syscall(SYS_gettid);
@@ -165,6 +244,67 @@ namespace {
         {
         }
     };
+
+    /** Ruby-side wrapper for the ports created by do_create_port
+     *
+     * It resolves, once at port creation time, everything the read and write
+     * paths need to marshal samples. This keeps type registry lookups and
+     * dynamic casts out of the per-sample path.
+     */
+    struct RLocalPort {
+        RTT::base::PortInterface* port;
+        RTT::types::TypeInfo* type_info;
+        orogen_transports::TypelibMarshallerBase* typelib_transport;
+        /** Whether samples can be read and written directly from the Ruby
+         * memory, i.e. the type is not opaque
+         */
+        bool plain;
+        /** Owns the memory plain_ds points to while it is not bound to a
+         * Ruby sample
+         */
+        RTT::base::DataSourceBase::shared_ptr plain_sample;
+        /** Reference data source re-targetted to the Ruby sample on each
+         * call on plain types
+         */
+        RTT::base::DataSourceBase::shared_ptr plain_ds;
+        RTT::internal::Reference* plain_ref;
+        /** Marshalling handles for opaque types */
+        HandlePool* handle_pool;
+
+        RLocalPort(RTT::base::PortInterface* port,
+            RTT::types::TypeInfo* type_info,
+            orogen_transports::TypelibMarshallerBase* typelib_transport)
+            : port(port)
+            , type_info(type_info)
+            , typelib_transport(typelib_transport)
+            , plain(!typelib_transport || typelib_transport->isPlainTypelibType())
+            , plain_ref(0)
+            , handle_pool(0)
+        {
+            if (!plain) {
+                handle_pool = &HandlePool::forType(type_info, typelib_transport);
+                return;
+            }
+
+            plain_sample = type_info->buildValue();
+            plain_ds = type_info->buildReference(plain_sample->getRawPointer());
+            plain_ref = dynamic_cast<RTT::internal::Reference*>(plain_ds.get());
+        }
+
+        /** Returns a data source that refers to the given memory
+         *
+         * Only valid for plain types. The returned data source is shared, and
+         * is therefore only valid until the next call to this method
+         */
+        RTT::base::DataSourceBase::shared_ptr bindPlainSample(void* data)
+        {
+            if (!plain_ref)
+                return type_info->buildReference(data);
+
+            plain_ref->setReference(data);
+            return plain_ds;
+        }
+    };
 }
 
 static LocalTaskContext& local_task_context(VALUE obj)
@@ -193,6 +333,7 @@ static void local_task_context_dispose(RLocalTaskContext* rtask)
         (*it)->disconnect();
         (*it)->setInterface(0);
     }
+    unregister_collocated_task(task);
     RTT::corba::TaskContextServer::CleanupServer(task);
     delete task;
     rtask->tc = 0;
@@ -218,6 +359,7 @@ static VALUE local_task_context_new(VALUE klass, VALUE _name, VALUE use_naming)
 #endif
 
     RTT::corba::TaskContextServer::Create(ruby_task, RTEST(use_naming));
+    register_collocated_task(RTT::corba::TaskContextServer::getIOR(ruby_task), ruby_task);
 
     VALUE rlocal_task = Data_Wrap_Struct(cLocalTaskContext,
         0,
@@ -241,13 +383,34 @@ static VALUE local_task_context_ior(VALUE _task)
     return rb_str_new(ior.c_str(), ior.length());
 }
 
-static void delete_rtt_ruby_port(RTT::base::PortInterface* port)
+static void delete_rtt_ruby_port(RLocalPort* rport)
 {
+    std::unique_ptr<RLocalPort> guard(rport);
+    RTT::base::PortInterface* port = rport->port;
+    remove_port_notifier(port);
     if (port->getInterface())
         port->getInterface()->removePort(port->getName());
     delete port;
 }
 
+template <typename Port> static Port& local_port(VALUE obj)
+{
+    return static_cast<Port&>(*get_wrapped<RLocalPort>(obj).port);
+}
+
+static VALUE flow_status_to_ruby(RTT::FlowStatus status)
+{
+    switch (status) {
+        case RTT::NoData:
+            return Qfalse;
+        case RTT::OldData:
+            return INT2FIX(0);
+        case RTT::NewData:
+            return INT2FIX(1);
+    }
+    return Qnil; // Never reached
+}
+
 static void delete_rtt_ruby_property(RTT::base::PropertyBase* property)
 {
     delete property;
@@ -298,6 +461,9 @@ static VALUE local_task_context_create_port(VALUE _task,
             "it seems that the typekit for %s does not include the necessary factory",
             type_name.c_str());
 
+    orogen_transports::TypelibMarshallerBase* typelib_transport =
+        get_typelib_transport(ti, false);
+
     RTT::base::PortInterface* port;
     VALUE ruby_port;
     if (RTEST(_is_output))
@@ -305,7 +471,10 @@ static VALUE local_task_context_create_port(VALUE _task,
     else
         port = factory->inputPort(port_name);
 
-    ruby_port = Data_Wrap_Struct(_klass, 0, delete_rtt_ruby_port, port);
+    ruby_port = Data_Wrap_Struct(_klass,
+        0,
+        delete_rtt_ruby_port,
+        new RLocalPort(port, ti, typelib_transport));
     local_task_context(_task).ports()->addPort(*port);
 
     VALUE args[4] = {rb_iv_get(_task, "@remote_task"), _port_name, _port_model};
@@ -325,6 +494,7 @@ static VALUE local_task_context_remove_port(VALUE obj, VALUE _port_name)
             task.getName().c_str(),
             port_name.c_str());
 
+    remove_port_notifier(port);
     // Workaround a bug in RTT. The port's data flow interface is not reset
     port->setInterface(0);
     di.removePort(port_name);
@@ -396,131 +566,394 @@ static VALUE local_task_context_create_attribute(VALUE _task,
     return ruby_attribute;
 }
 
+/** Reads a sample from a local input port, recording the error message
+ * instead of throwing
+ *
+ * It is used while a handle of the port's pool is acquired, which must be
+ * released before the Ruby exception gets raised
+ */
+static RTT::FlowStatus read_local_sample_nothrow(
+    RTT::base::InputPortInterface* local_port,
+    RTT::base::DataSourceBase::shared_ptr ds,
+    bool copy_old_data,
+    std::string* error)
+{
+    try {
+        return local_port->read(ds, copy_old_data);
+    }
+    catch (std::exception& e) {
+        *error = e.what();
+        return RTT::NoData;
+    }
+}
+
+/** Reads a sample from a local input port into the given typelib value
+ *
+ * The value must be of the port's typelib type, i.e. the intermediate type
+ * for opaques
+ */
+static RTT::FlowStatus read_local_sample(RLocalPort& rport,
+    Typelib::Value value,
+    bool copy_old_data,
+    bool blocking_read)
+{
+    RTT::base::InputPortInterface& local_port =
+        static_cast<RTT::base::InputPortInterface&>(*rport.port);
+
+    if (rport.plain) {
+        if (!blocking_read)
+            return local_port.read(rport.bindPlainSample(value.getData()),
+                copy_old_data);
+
+        // The shared reference data source cannot be used while the GVL
+        // is released, as another Ruby thread could re-target it
+        RTT::base::DataSourceBase::shared_ptr ds =
+            rport.type_info->buildReference(value.getData());
+        return blocking_fct_call_with_result(
+            boost::bind(&RTT::base::InputPortInterface::read,
+                &local_port,
+                ds,
+                copy_old_data));
+    }
+
+    // Check it before acquiring the handle, as it raises
+    if (blocking_read)
+        verify_thread_interdiction();
+
+    orogen_transports::TypelibMarshallerBase* typelib_transport =
+        rport.typelib_transport;
+    HandlePool::Entry entry = rport.handle_pool->acquire();
+    orogen_transports::TypelibMarshallerBase::Handle* handle = entry.handle;
+    // Set the typelib sample using the value passed from ruby to avoid
+    // unnecessary convertions. Don't touch the orocos sample though. The
+    // conversion after the read then writes into the Ruby value directly.
+    //
+    // Since no typelib-to-orocos conversion happens, the conversion method
+    // is not called and we don't have to catch a possible conversion error
+    // exception
+    //
+    // If the remote side sends us invalid data, it will be rejected at the
+    // CORBA layer
+    typelib_transport->setTypelibSample(handle, value, false);
+    //
+    // No Ruby exception may be raised until the entry is released, so errors
+    // are recorded and raised afterwards
+    RTT::base::DataSourceBase::shared_ptr ds = entry.data_source;
+    std::string error;
+    RTT::FlowStatus did_read;
+    if (blocking_read)
+        did_read = blocking_fct_call_with_result(boost::bind(&read_local_sample_nothrow,
+            &local_port,
+            ds,
+            copy_old_data,
+            &error));
+    else
+        did_read = read_local_sample_nothrow(&local_port, ds, copy_old_data, &error);
+
+    if (error.empty() &&
+        (did_read == RTT::NewData || (did_read == RTT::OldData && copy_old_data))) {
+        try {
+            rport.handle_pool->refreshTypelibSample(entry, value);
+        }
+        catch (std::exception& e) {
+            error = e.what();
+        }
+    }
+
+    rport.handle_pool->release(entry);
+    if (!error.empty())
+        rb_raise(eCORBA,
+            "failed to read %s: %s",
+            rport.type_info->getTypeName().c_str(),
+            error.c_str());
+    return did_read;
+}
+
+/** call-seq:
+ *     do_read(typelib_value, copy_old_data, blocking_read)
+ *
+ */
 static VALUE local_input_port_read(VALUE _local_port,
-    VALUE type_name,
     VALUE rb_typelib_value,
     VALUE copy_old_data,
     VALUE blocking_read)
 {
-    RTT::base::InputPortInterface& local_port =
-        get_wrapped<RTT::base::InputPortInterface>(_local_port);
+    RLocalPort& rport = get_wrapped<RLocalPort>(_local_port);
     Typelib::Value value = typelib_get(rb_typelib_value);
+    return flow_status_to_ruby(
+        read_local_sample(rport, value, RTEST(copy_old_data), RTEST(blocking_read)));
+}
 
-    RTT::types::TypeInfo* ti = get_type_info(StringValuePtr(type_name));
-    orogen_transports::TypelibMarshallerBase* typelib_transport =
-        get_typelib_transport(ti, false);
+/** call-seq:
+ *     do_drain(typelib_array) => count
+ *
+ * Reads all new samples queued on this port, up to the size of the given
+ * typelib array, without releasing the GVL. The array's element type must be
+ * the port's typelib type. Samples are stored at the beginning of the array.
+ *
+ * Returns the number of samples read
+ */
+static VALUE local_input_port_drain(VALUE _local_port, VALUE rb_buffer)
+{
+    RLocalPort& rport = get_wrapped<RLocalPort>(_local_port);
+    Typelib::Value buffer = typelib_get(rb_buffer);
+    if (buffer.getType().getCategory() != Typelib::Type::Array)
+        rb_raise(rb_eArgError,
+            "expected a typelib array, got %s",
+            buffer.getType().getName().c_str());
 
-    if (!typelib_transport || typelib_transport->isPlainTypelibType()) {
-        RTT::base::DataSourceBase::shared_ptr ds = ti->buildReference(value.getData());
-        RTT::FlowStatus did_read;
-        if (RTEST(blocking_read))
-            did_read = blocking_fct_call_with_result(
-                boost::bind(&RTT::base::InputPortInterface::read,
-                    &local_port,
-                    ds,
-                    RTEST(copy_old_data)));
-        else
-            did_read = local_port.read(ds, RTEST(copy_old_data));
-
-        switch (did_read) {
-            case RTT::NoData:
-                return Qfalse;
-            case RTT::OldData:
-                return INT2FIX(0);
-            case RTT::NewData:
-                return INT2FIX(1);
-        }
+    Typelib::Array const& array_t = static_cast<Typelib::Array const&>(buffer.getType());
+    Typelib::Type const& element_t = array_t.getIndirection();
+    size_t element_size = element_t.getSize();
+    uint8_t* data = static_cast<uint8_t*>(buffer.getData());
+
+    size_t count = 0;
+    for (; count < array_t.getDimension(); ++count) {
+        Typelib::Value element(data + count * element_size, element_t);
+        if (read_local_sample(rport, element, false, false) != RTT::NewData)
+            break;
     }
-    else {
-        orogen_transports::TypelibMarshallerBase::Handle* handle =
-            typelib_transport->createHandle();
-        // Set the typelib sample using the value passed from ruby to avoid
-        // unnecessary convertions. Don't touch the orocos sample though.
-        //
-        // Since no typelib-to-orocos conversion happens, the conversion method
-        // is not called and we don't have to catch a possible conversion error
-        // exception
-        //
-        // If the remote side sends us invalid data, it will be rejected at the
-        // CORBA layer
-        typelib_transport->setTypelibSample(handle, value, false);
-        RTT::base::DataSourceBase::shared_ptr ds =
-            typelib_transport->getDataSource(handle);
-        RTT::FlowStatus did_read;
-        if (RTEST(blocking_read))
-            did_read = blocking_fct_call_with_result(
-                boost::bind(&RTT::base::InputPortInterface::read,
-                    &local_port,
-                    ds,
-                    RTEST(copy_old_data)));
-        else
-            did_read = local_port.read(ds, RTEST(copy_old_data));
-
-        if (did_read == RTT::NewData ||
-            (did_read == RTT::OldData && RTEST(copy_old_data))) {
-            typelib_transport->refreshTypelibSample(handle);
-            Typelib::copy(value,
-                Typelib::Value(typelib_transport->getTypelibSample(handle),
-                    value.getType()));
-        }
+    return SIZET2NUM(count);
+}
 
-        typelib_transport->deleteHandle(handle);
-        switch (did_read) {
-            case RTT::NoData:
-                return Qfalse;
-            case RTT::OldData:
-                return INT2FIX(0);
-            case RTT::NewData:
-                return INT2FIX(1);
-        }
+/** call-seq:
+ *     do_enable_notification => fd
+ *
+ * Creates a pipe that gets written to each time a new sample arrives on this
+ * port, and returns its read end. Each notification is the sample's arrival
+ * time, as a native 64 bit integer holding the CLOCK_MONOTONIC time in
+ * nanoseconds. Calling it more than once returns the same
+ * file descriptor.
+ *
+ * The caller takes ownership of the read end, and must close it. The write
+ * end is closed when the port is removed or garbage collected, or when
+ * #do_disable_notification is called.
+ */
+static VALUE local_input_port_enable_notification(VALUE _local_port)
+{
+    RTT::base::InputPortInterface& port =
+        local_port<RTT::base::InputPortInterface>(_local_port);
+    {
+        boost::mutex::scoped_lock lock(port_notifiers_mutex);
+        PortNotifiers::const_iterator it = port_notifiers.find(&port);
+        if (it != port_notifiers.end())
+            return INT2FIX(it->second.read_fd);
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) == -1)
+        rb_sys_fail("failed to create the notification pipe");
+
+    {
+        boost::mutex::scoped_lock lock(port_notifiers_mutex);
+        PortNotifier notifier = {fds[0], fds[1]};
+        port_notifiers[&port] = notifier;
+    }
+    port.signalInterface(true);
+    return INT2FIX(fds[0]);
+}
+
+static VALUE local_input_port_disable_notification(VALUE _local_port)
+{
+    RTT::base::InputPortInterface& port =
+        local_port<RTT::base::InputPortInterface>(_local_port);
+    port.signalInterface(false);
+    remove_port_notifier(&port);
+    return Qnil;
+}
+
+namespace {
+    struct WaitAnyCall {
+        std::vector<pollfd> fds;
+        int timeout_ms;
+        int result;
+        int error;
+    };
+
+    void* wait_any_poll(void* ptr)
+    {
+        WaitAnyCall& call = *static_cast<WaitAnyCall*>(ptr);
+        pollfd* fds = call.fds.empty() ? NULL : &call.fds[0];
+        call.result = poll(fds, call.fds.size(), call.timeout_ms);
+        call.error = errno;
+        return NULL;
     }
-    return Qnil; // Never reached
 }
+
+/** call-seq:
+ *     LocalInputPort.do_wait_any(fds, timeout_ms) => ready_indexes or nil
+ *
+ * Waits, with the GVL released, until one of the given notification file
+ * descriptors (as returned by #do_enable_notification) becomes readable or
+ * the timeout expires. A negative timeout waits forever.
+ *
+ * Returns the indexes in +fds+ of the descriptors that are readable, or nil
+ * if the wait got interrupted by a signal
+ */
+static VALUE local_input_port_wait_any(VALUE klass, VALUE rb_fds, VALUE timeout_ms)
+{
+    WaitAnyCall call;
+    long size = RARRAY_LEN(rb_fds);
+    call.fds.resize(size);
+    for (long i = 0; i < size; ++i) {
+        call.fds[i].fd = NUM2INT(rb_ary_entry(rb_fds, i));
+        call.fds[i].events = POLLIN;
+        call.fds[i].revents = 0;
+    }
+    call.timeout_ms = NUM2INT(timeout_ms);
+    call.result = 0;
+    call.error = 0;
+    if (size == 0 && call.timeout_ms < 0)
+        rb_raise(rb_eArgError, "cannot wait forever on an empty set of ports");
+    // A zero timeout only polls, which is allowed in the forbidden thread
+    if (call.timeout_ms != 0)
+        verify_thread_interdiction();
+
+    // RUBY_UBF_IO interrupts poll() with a signal, which lets Ruby handle
+    // Thread#raise, Thread#kill or Ctrl+C while we wait
+    rb_thread_call_without_gvl(&wait_any_poll, &call, RUBY_UBF_IO, NULL);
+
+    if (call.result == -1) {
+        if (call.error == EINTR)
+            return Qnil;
+        errno = call.error;
+        rb_sys_fail("failed to wait for the port notifications");
+    }
+
+    VALUE result = rb_ary_new();
+    for (long i = 0; i < size; ++i) {
+        if (call.fds[i].revents != 0)
+            rb_ary_push(result, LONG2NUM(i));
+    }
+    return result;
+}
+
 static VALUE local_input_port_clear(VALUE _local_port)
 {
-    RTT::base::InputPortInterface& local_port =
-        get_wrapped<RTT::base::InputPortInterface>(_local_port);
-    local_port.clear();
+    local_port<RTT::base::InputPortInterface>(_local_port).clear();
     return Qnil;
 }
 
-static VALUE local_output_port_write(VALUE _local_port,
-    VALUE rb_type_name,
-    VALUE rb_typelib_value)
+/** Writes a data source on a local output port
+ *
+ * Returns true if the sample has been accepted by the port's connections
+ */
+static bool write_local_sample(RTT::base::OutputPortInterface& local_port,
+    RTT::base::DataSourceBase::shared_ptr ds)
 {
+#if RTT_VERSION_GTE(2, 8, 99)
+    return local_port.write(ds) == RTT::WriteSuccess;
+#else
+    local_port.write(ds);
+    return local_port.connected();
+#endif
+}
+
+/** call-seq:
+ *     do_write(typelib_value)
+ *
+ */
+static VALUE local_output_port_write(VALUE _local_port, VALUE rb_typelib_value)
+{
+    RLocalPort& rport = get_wrapped<RLocalPort>(_local_port);
     RTT::base::OutputPortInterface& local_port =
-        get_wrapped<RTT::base::OutputPortInterface>(_local_port);
+        static_cast<RTT::base::OutputPortInterface&>(*rport.port);
     Typelib::Value value = typelib_get(rb_typelib_value);
-    std::string type_name(StringValuePtr(rb_type_name));
 
-    orogen_transports::TypelibMarshallerBase* transport = 0;
-    RTT::types::TypeInfo* ti = get_type_info(type_name);
-    if (ti && ti->hasProtocol(orogen_transports::TYPELIB_MARSHALLER_ID)) {
-        transport = dynamic_cast<orogen_transports::TypelibMarshallerBase*>(
-            ti->getProtocol(orogen_transports::TYPELIB_MARSHALLER_ID));
-    }
-
-    if (!transport) {
-        RTT::base::DataSourceBase::shared_ptr ds = ti->buildReference(value.getData());
-        local_port.write(ds);
+    if (rport.plain) {
+        local_port.write(rport.bindPlainSample(value.getData()));
     }
     else {
-        orogen_transports::TypelibMarshallerBase::Handle* handle =
-            transport->createHandle();
+        orogen_transports::TypelibMarshallerBase* transport = rport.typelib_transport;
+        HandlePool::Entry entry = rport.handle_pool->acquire();
 
         try {
-            transport->setTypelibSample(handle, static_cast<uint8_t*>(value.getData()));
+            transport->setTypelibSample(entry.handle,
+                static_cast<uint8_t*>(value.getData()));
         }
         catch (std::exception& e) {
-            rb_raise(eCORBA, "failed to marshal %s: %s", type_name.c_str(), e.what());
+            rport.handle_pool->release(entry);
+            rb_raise(eCORBA,
+                "failed to marshal %s: %s",
+                rport.type_info->getTypeName().c_str(),
+                e.what());
         }
-        RTT::base::DataSourceBase::shared_ptr ds = transport->getDataSource(handle);
-        local_port.write(ds);
-        transport->deleteHandle(handle);
+        local_port.write(entry.data_source);
+        rport.handle_pool->release(entry);
     }
     return local_port.connected() ? Qtrue : Qfalse;
 }
 
+/** call-seq:
+ *     do_write_many(typelib_array, sample_count) => count
+ *
+ * Writes the first sample_count samples of the given typelib array, in order,
+ * without returning to Ruby in between. The array's element type must be the
+ * port's typelib type.
+ *
+ * Returns the number of samples that have been accepted by the port's
+ * connections
+ */
+static VALUE local_output_port_write_many(VALUE _local_port,
+    VALUE rb_samples,
+    VALUE rb_sample_count)
+{
+    RLocalPort& rport = get_wrapped<RLocalPort>(_local_port);
+    RTT::base::OutputPortInterface& local_port =
+        static_cast<RTT::base::OutputPortInterface&>(*rport.port);
+    Typelib::Value samples = typelib_get(rb_samples);
+    if (samples.getType().getCategory() != Typelib::Type::Array)
+        rb_raise(rb_eArgError,
+            "expected a typelib array, got %s",
+            samples.getType().getName().c_str());
+
+    Typelib::Array const& array_t =
+        static_cast<Typelib::Array const&>(samples.getType());
+    size_t element_size = array_t.getIndirection().getSize();
+    size_t sample_count = NUM2SIZET(rb_sample_count);
+    if (sample_count > array_t.getDimension())
+        rb_raise(rb_eArgError,
+            "cannot write %i samples from an array of %i",
+            static_cast<int>(sample_count),
+            static_cast<int>(array_t.getDimension()));
+    uint8_t* data = static_cast<uint8_t*>(samples.getData());
+
+    size_t accepted = 0;
+    if (rport.plain) {
+        for (size_t i = 0; i < sample_count; ++i) {
+            if (write_local_sample(local_port,
+                    rport.bindPlainSample(data + i * element_size)))
+                ++accepted;
+        }
+        return SIZET2NUM(accepted);
+    }
+
+    orogen_transports::TypelibMarshallerBase* transport = rport.typelib_transport;
+    HandlePool::Entry entry = rport.handle_pool->acquire();
+    std::string error;
+    size_t i = 0;
+    for (; i < sample_count; ++i) {
+        try {
+            transport->setTypelibSample(entry.handle, data + i * element_size);
+        }
+        catch (std::exception& e) {
+            error = e.what();
+            break;
+        }
+        if (write_local_sample(local_port, entry.data_source))
+            ++accepted;
+    }
+    rport.handle_pool->release(entry);
+
+    if (!error.empty())
+        rb_raise(eCORBA,
+            "failed to marshal %s at index %i: %s",
+            rport.type_info->getTypeName().c_str(),
+            static_cast<int>(i),
+            error.c_str());
+    return SIZET2NUM(accepted);
+}
+
 void runkit::rtt_corba_init_ruby_task_context(VALUE mRoot,
     VALUE cTaskContext,
     VALUE cOutputPort,
@@ -571,12 +1004,32 @@ void runkit::rtt_corba_init_ruby_task_context(VALUE mRoot,
     rb_define_method(cLocalOutputPort,
         "do_write",
         RUBY_METHOD_FUNC(local_output_port_write),
+        1);
+    rb_define_method(cLocalOutputPort,
+        "do_write_many",
+        RUBY_METHOD_FUNC(local_output_port_write_many),
         2);
     cLocalInputPort = rb_define_class_under(mRubyTasks, "LocalInputPort", cInputPort);
     rb_define_method(cLocalInputPort,
         "do_read",
         RUBY_METHOD_FUNC(local_input_port_read),
-        4);
+        3);
+    rb_define_method(cLocalInputPort,
+        "do_drain",
+        RUBY_METHOD_FUNC(local_input_port_drain),
+        1);
+    rb_define_method(cLocalInputPort,
+        "do_enable_notification",
+        RUBY_METHOD_FUNC(local_input_port_enable_notification),
+        0);
+    rb_define_method(cLocalInputPort,
+        "do_disable_notification",
+        RUBY_METHOD_FUNC(local_input_port_disable_notification),
+        0);
+    rb_define_singleton_method(cLocalInputPort,
+        "do_wait_any",
+        RUBY_METHOD_FUNC(local_input_port_wait_any),
+        2);
     rb_define_method(cLocalInputPort,
         "do_clear",
         RUBY_METHOD_FUNC(local_input_port_clear),
@@ -29,6 +29,7 @@
 require "ruby2_keywords"
 require "runkit/base"
 require "runkit/typekits"
+require "runkit/memory_view"
 
 # Low-level interface to Rock components
 module Runkit
@@ -49,7 +50,9 @@ module Runkit
 
 require "runkit/name_services/base"
 require "runkit/name_services/corba"
+require "runkit/name_services/corba_watcher"
 require "runkit/name_services/local"
+require "runkit/name_services/ior_cache"
 require "runkit/name_service"
 
 require "runkit/port_base"
@@ -66,6 +69,7 @@ module Runkit
 require "runkit/property"
 require "runkit/operations"
 require "runkit/task_context"
+require "runkit/async_call"
 
 require "runkit/process"
 require "runkit/corba"
@@ -80,6 +84,8 @@ module Runkit
 require "runkit/ruby_tasks/stub_task_context"
 require "runkit/input_writer"
 require "runkit/output_reader"
+require "runkit/state_subscription"
+require "runkit/connection_graph"
 
 require "utilrb/hash/recursive_merge"
 require "runkit/configurations"
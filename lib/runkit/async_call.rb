@@ -0,0 +1,49 @@
+# frozen_string_literal: true
+
+require "io/wait"
+
+module Runkit
+    # A remote call executed in the background by a pool of worker threads
+    #
+    # Instances are returned by the *_async methods, e.g.
+    # {TaskContext#read_toplevel_state_async}, {Property#read_async} or
+    # {Operation#callop_async}. The size of the worker pool is controlled by
+    # {CORBA.async_worker_count=}, which must be set before the first call
+    class AsyncCall
+        # @api private
+        #
+        # Sets the object the call is made on (for error messages) and the
+        # block that converts the call's raw result into the value returned
+        # by {#value}
+        def setup(target, &transform)
+            @target = target
+            @transform = transform
+            self
+        end
+
+        # Waits for the call to finish
+        #
+        # When a Fiber scheduler is active, only the calling fiber waits.
+        # Otherwise, the calling thread is blocked.
+        #
+        # @param [Numeric,nil] timeout how long to wait in seconds. Waits
+        #   until the call finishes if nil.
+        # @return [Boolean] true if the call is finished
+        def wait(timeout = nil)
+            return true unless (fd = do_wait_fd)
+
+            IO.for_fd(fd, autoclose: false).wait_readable(timeout)
+            done?
+        end
+
+        # Waits for the call to finish, and returns its result
+        #
+        # @raise [CORBA::ComError] if the communication with the remote
+        #   object failed
+        def value
+            wait
+            raw = CORBA.refine_exceptions(@target) { do_value }
+            @transform ? @transform.call(raw) : raw
+        end
+    end
+end
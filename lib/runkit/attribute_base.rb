@@ -40,15 +40,23 @@ def log_metadata
             ]
         end
 
-        def raw_read
+        # Read the current value of the property/attribute as a Typelib value
+        #
+        # @param [Numeric,nil] timeout the call timeout in seconds, see
+        #   {CORBA.with_call_timeout}
+        def raw_read(timeout: nil)
             value = type.new
-            do_read(@runkit_type_name, value)
+            CORBA.with_call_timeout(timeout) do
+                do_read(@runkit_type_name, value)
+            end
             value
         end
 
         # Read the current value of the property/attribute
-        def read
-            Typelib.to_ruby(raw_read)
+        #
+        # @param (see #raw_read)
+        def read(timeout: nil)
+            Typelib.to_ruby(raw_read(timeout: timeout))
         end
 
         # Sets a new value for the property/attribute
@@ -159,11 +159,13 @@ def self.initialized?
     end
 
     # Load system info and initialize the communication layer
-    def self.initialize
+    #
+    # @param corba_options options for {CORBA.initialize}
+    def self.initialize(**corba_options)
         self.load unless loaded?
         Runkit.update_typekit_main_thread
 
-        Runkit::CORBA.initialize
+        Runkit::CORBA.initialize(**corba_options)
         @initialized = true
         @ruby_task = RubyTasks::TaskContext.new(@runkit_self_name)
     end
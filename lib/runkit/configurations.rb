@@ -812,8 +812,15 @@ def conf_as_typelib(names, override: false)
         #   a configuration value as a mapping from property names to
         #   configuration object
         # @param [Boolean] override the override argument of {#conf}
-        # @return [void]
-        def apply(task, config, override = false)
+        # @param [Boolean] diff if true, only write the properties whose value
+        #   differs from the one in the task's {TaskContext#property_cache}.
+        #   The cache is filled with the values read from the task the first
+        #   time, and updated with the values written. It assumes that the
+        #   properties are not changed by other means in between, see
+        #   {TaskContext#property_cache}
+        # @return [ApplyResult,nil] the number of written and skipped
+        #   properties, or nil if there was no configuration to apply
+        def apply(task, config, override = false, diff: false)
             config = conf(config, override) unless config.kind_of?(Hash)
 
             unless config
@@ -830,11 +837,105 @@ def apply(task, config, override = false)
                 return
             end
 
-            config.each do |prop_name, conf|
-                p = task.property(prop_name)
-                result = p.raw_read
-                result = TaskConfigurations.apply_conf_on_typelib_value(result, conf)
-                p.write(result)
+            if !task.respond_to?(:write_properties)
+                config.each do |prop_name, conf|
+                    p = task.property(prop_name)
+                    result = p.raw_read
+                    result = TaskConfigurations.apply_conf_on_typelib_value(result, conf)
+                    p.write(result)
+                end
+                ApplyResult.new(config.size, 0)
+            elsif diff
+                apply_diff(task, config)
+            else
+                apply_bulk(task, config)
+            end
+        end
+
+        # Result of {#apply}
+        #
+        # @!attribute [r] written
+        #   @return [Integer] the number of properties written to the task
+        # @!attribute [r] skipped
+        #   @return [Integer] the number of properties that were not written
+        #     because their value did not change
+        ApplyResult = Struct.new(:written, :skipped)
+
+        # @api private
+        #
+        # Implementation of {#apply} for the tasks that can read and write their
+        # properties in bulk
+        def apply_bulk(task, config)
+            current = task.raw_read_properties(config.keys)
+            new_values = config.each_with_object({}) do |(prop_name, conf), values|
+                value = current[prop_name.to_s]
+                raise value if value.kind_of?(Exception)
+
+                values[prop_name.to_s] =
+                    TaskConfigurations.apply_conf_on_typelib_value(value, conf)
+            end
+
+            bulk_write(task, new_values)
+            ApplyResult.new(new_values.size, 0)
+        end
+
+        # @api private
+        #
+        # Implementation of {#apply} in diff mode
+        def apply_diff(task, config)
+            cache = task.property_cache
+            missing = config.keys.map(&:to_s).reject { |name| cache.key?(name) }
+            unless missing.empty?
+                task.raw_read_properties(missing).each do |name, value|
+                    raise value if value.kind_of?(Exception)
+
+                    cache[name] = value
+                end
+            end
+
+            changed = config.each_with_object({}) do |(prop_name, conf), values|
+                current = cache[prop_name.to_s]
+                value = TaskConfigurations.apply_conf_on_typelib_value(
+                    current.dup, conf
+                )
+                next if value.to_byte_array == current.to_byte_array
+
+                values[prop_name.to_s] = value
+            end
+
+            bulk_write(task, changed) do |name, value, success|
+                if success
+                    cache[name] = value
+                else
+                    cache.delete(name)
+                end
+            end
+            ApplyResult.new(changed.size, config.size - changed.size)
+        end
+
+        # @api private
+        #
+        # Writes the properties with {TaskContext#write_properties}, and raises
+        # if one of the writes failed
+        #
+        # @yieldparam [String] name the property name
+        # @yieldparam [Typelib::Type] value the value that was to be written
+        # @yieldparam [Boolean] success whether the write succeeded
+        def bulk_write(task, values)
+            results = task.write_properties(values)
+            if block_given?
+                results.each do |name, result|
+                    yield(name, values[name], result == true)
+                end
+            end
+
+            results.each do |name, result|
+                raise result if result.kind_of?(Exception)
+                next if result
+
+                raise ArgumentError,
+                      "failed to write property #{name} on task #{task.name}: "\
+                      "the task rejected the value"
             end
         end
 
@@ -1239,6 +1340,8 @@ def find_task_configuration_object(task, options = {})
         #   model that should be used to resolve the configurations
         # @option options [Boolean] :override (false) see the documentation of
         #   {TaskConfigurations#apply}
+        # @option options [Boolean] :diff (false) see the documentation of
+        #   {TaskConfigurations#apply}
         # @raise (see TaskConfigurations#apply)
         def apply(task, names = [], options = {})
             if [true, false].include?(options)
@@ -1246,7 +1349,7 @@ def apply(task, names = [], options = {})
                 options = Hash[override: options]
             end
             options, find_options = Kernel.filter_options(
-                options, override: false, model_name: task.model.name
+                options, override: false, diff: false, model_name: task.model.name
             )
 
             model_name = options[:model_name]
@@ -1265,7 +1368,15 @@ def apply(task, names = [], options = {})
                     "applying configuration #{names.join(', ')} on #{task.name} "\
                     "of type #{model_name}"
                 )
-                task_conf.apply(task, names, options[:override])
+                result = task_conf.apply(
+                    task, names, options[:override], diff: options[:diff]
+                )
+                if result && options[:diff]
+                    ConfigurationManager.info(
+                        "  wrote #{result.written} properties, skipped "\
+                        "#{result.skipped} unchanged ones"
+                    )
+                end
             else
                 ConfigurationManager.info(
                     "required default configuration on #{task.name} of type "\
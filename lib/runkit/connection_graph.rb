@@ -0,0 +1,202 @@
+# frozen_string_literal: true
+
+module Runkit
+    # Brings the connections between ports to a desired state
+    #
+    # The graph keeps track of the connections it created. {#apply} compares
+    # the desired connections with them and only touches the ones that differ:
+    # it removes the connections that are not desired anymore, creates the
+    # new ones and re-creates the ones whose policy changed. Switching between
+    # two sets of connections therefore does not disconnect and reconnect the
+    # connections they share.
+    #
+    # Connections are identified by the full names of their ports, so that
+    # the ports may be resolved again between two calls to {#apply}
+    class ConnectionGraph
+        # A connection between two ports
+        #
+        # @!attribute [r] output
+        #   @return [OutputPort]
+        # @!attribute [r] input
+        #   @return [InputPort]
+        # @!attribute [r] policy
+        #   @return [Hash] the connection policy, as given to
+        #     {OutputPort#connect_to}
+        Edge = Struct.new(:output, :input, :policy) do
+            # The key of this edge in {ConnectionGraph#applied}
+            def key
+                [output.full_name, input.full_name]
+            end
+        end
+
+        # The changes needed to go from the applied connections to the desired
+        # ones
+        #
+        # @!attribute [r] added
+        #   @return [Array<Edge>] the connections to create
+        # @!attribute [r] removed
+        #   @return [Array<Edge>] the connections to remove
+        # @!attribute [r] reconnected
+        #   @return [Array<Edge>] the connections to re-create because their
+        #     policy changed
+        Plan = Struct.new(:added, :removed, :reconnected) do
+            def empty?
+                added.empty? && removed.empty? && reconnected.empty?
+            end
+        end
+
+        # The outcome of {#apply}
+        #
+        # @!attribute [r] plan
+        #   @return [Plan] the plan that has been executed
+        # @!attribute [r] errors
+        #   @return [Hash<Edge,Exception>] the edges that could not be
+        #     created or removed, and the corresponding error
+        Result = Struct.new(:plan, :errors) do
+            def success?
+                errors.empty?
+            end
+        end
+
+        # The connections that have been successfully created by {#apply}
+        #
+        # @return [Hash<(String,String),Edge>] the connections, indexed by the
+        #   full names of their output and input ports
+        attr_reader :applied
+
+        # @param [Array<(OutputPort,InputPort,Hash)>,Array<Edge>] applied
+        #   connections that are known to exist already, e.g. because they have
+        #   been created by another graph
+        def initialize(applied = [])
+            @applied = normalize_edges(applied)
+        end
+
+        # Computes the changes needed to go from the applied connections to
+        # the desired ones
+        #
+        # @param [Array<(OutputPort,InputPort,Hash)>,Array<Edge>] desired
+        # @return [Plan]
+        def plan(desired)
+            desired = normalize_edges(desired)
+            plan = Plan.new([], [], [])
+            desired.each do |key, edge|
+                if !(current = @applied[key])
+                    plan.added << edge
+                elsif current.policy != edge.policy
+                    plan.reconnected << edge
+                end
+            end
+            @applied.each do |key, edge|
+                plan.removed << edge unless desired.key?(key)
+            end
+            plan
+        end
+
+        # Changes the connections to match the desired ones
+        #
+        # The removals are done first, and then the creations. Each step is
+        # done in parallel (see {Runkit.disconnect_all} and
+        # {Runkit.connect_all}). The edges that fail are reported in the
+        # result, without preventing the others from being applied. An edge
+        # that could not be created is not registered in {#applied}, and will
+        # therefore be tried again by the next call.
+        #
+        # @param [Array<(OutputPort,InputPort,Hash)>,Array<Edge>] desired
+        # @param [Boolean] check if true, the graph first verifies that the
+        #   ports of the applied connections are still connected, and
+        #   re-creates the connections of the ports that are not. This costs
+        #   one remote call per port, see {#forget_disconnected}.
+        # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+        #   {CORBA.with_call_timeout}
+        # @return [Result]
+        def apply(desired, check: false, timeout: nil)
+            forget_disconnected(timeout: timeout) if check
+
+            plan = plan(desired)
+            errors = {}
+            disconnect_edges(plan.removed + plan.reconnected, errors, timeout)
+            connect_edges(plan.added + plan.reconnected, errors, timeout)
+            Result.new(plan, errors)
+        end
+
+        # Removes all the applied connections
+        #
+        # @return [Result]
+        def clear(timeout: nil)
+            apply([], timeout: timeout)
+        end
+
+        # Removes the applied connections whose ports are not connected
+        # anymore, e.g. because one of their tasks got restarted
+        #
+        # The ports are queried in parallel (see {Runkit.connected_all}), once
+        # each. The check is done per port, not per connection: an edge whose
+        # connection got removed is not detected as long as both its ports
+        # still have other connections.
+        #
+        # @return [Array<Edge>] the edges that have been removed
+        def forget_disconnected(timeout: nil)
+            ports = @applied.each_value.flat_map { |e| [e.output, e.input] }
+            ports = ports.uniq(&:full_name)
+            results = Runkit.connected_all(ports, timeout: timeout)
+            connected = {}
+            ports.zip(results).each do |p, result|
+                if result.kind_of?(Exception) && !result.kind_of?(ComError)
+                    raise result
+                end
+
+                connected[p.full_name] = (result == true)
+            end
+
+            removed = @applied.each_value.find_all do |e|
+                !connected[e.output.full_name] || !connected[e.input.full_name]
+            end
+            removed.each { |e| @applied.delete(e.key) }
+            removed
+        end
+
+        private
+
+        # Converts the edges to {Edge} objects, with their policy filled with
+        # the default values so that equivalent policies compare equal
+        def normalize_edges(edges)
+            edges.each_with_object({}) do |edge, result|
+                output, input, policy = *edge
+                edge = Edge.new(output.to_runkit_port, input.to_runkit_port,
+                                Port.prepare_policy(**(policy || {})))
+                result[edge.key] = edge
+            end
+        end
+
+        def disconnect_edges(edges, errors, timeout)
+            return if edges.empty?
+
+            results = Runkit.disconnect_all(
+                edges.map { |e| [e.output, e.input] }, timeout: timeout
+            )
+            edges.zip(results).each do |edge, result|
+                if result.kind_of?(Exception)
+                    errors[edge] = result
+                else
+                    @applied.delete(edge.key)
+                end
+            end
+        end
+
+        def connect_edges(edges, errors, timeout)
+            edges = edges.reject { |e| errors.key?(e) }
+            return if edges.empty?
+
+            results = Runkit.connect_all(
+                edges.map { |e| [e.output, e.input, e.policy] }, timeout: timeout
+            )
+            edges.zip(results).each do |edge, result|
+                if result.kind_of?(Exception)
+                    errors[edge] = result
+                else
+                    @applied[edge.key] = edge
+                end
+            end
+        end
+    end
+end
@@ -51,8 +51,41 @@ def connect_timeout=(value)
                 do_connect_timeout(value)
                 @connect_timeout = value
             end
+
+            # Sets the timeout of the CORBA calls made by the current thread
+            # within the given block
+            #
+            # Unlike {#call_timeout=}, it does not affect the other threads.
+            # Calls made through {AsyncCall} use the timeout that was set
+            # when they were created.
+            #
+            # A call that does not complete within the timeout raises
+            # {TimeoutError}.
+            #
+            # @param [Numeric,nil] timeout the timeout in seconds. If nil, the
+            #   block is called with the current timeout.
+            def with_call_timeout(timeout)
+                return yield unless timeout
+
+                ms = (timeout * 1000).ceil
+                raise ArgumentError, "expected a positive timeout, got #{timeout}" if ms <= 0
+
+                key = :__runkit_call_timeout
+                current = Thread.current[key]
+                begin
+                    Thread.current[key] = ms
+                    yield
+                ensure
+                    Thread.current[key] = current
+                end
+            end
         end
 
+        # Per-thread timeouts (see {.with_call_timeout}) are disabled by
+        # default in omniORB. They can only be enabled before the CORBA layer
+        # is initialized
+        ENV["ORBsupportPerThreadTimeOut"] = "1" unless ENV["ORBsupportPerThreadTimeOut"]
+
         # The max message size is a DOS-protection feature. Honestly, given our
         # usage of CORBA, an attacker would have much worse ways to DOS a Rock
         # system.
@@ -65,10 +98,71 @@ def connect_timeout=(value)
         #
         # It does not need to be called explicitely, as it is called by
         # Runkit.initialize
-        def self.initialize
+        #
+        # The options control how the ORB communicates. They are ignored if
+        # the CORBA layer is already initialized.
+        #
+        # @param [Boolean] unix if true, the ORB listens on a unix socket on
+        #   top of TCP, and publishes both in its IORs. Processes on the same
+        #   machine that are initialized the same way then talk over the unix
+        #   socket, and the other ones over TCP
+        # @param [Array<String>] endpoints the endpoints the ORB listens on,
+        #   e.g. "giop:unix:" or "giop:tcp::2810" (omniORB's endPoint option).
+        #   The ORB listens on a TCP port chosen by the system if empty.
+        # @param [String,nil] end_point_publish which of the endpoints are
+        #   published in the IORs (omniORB's endPointPublish option), e.g.
+        #   "all(addr)"
+        # @param [Array<String>] client_transport_rules the transports used to
+        #   reach a given address, in order of preference (omniORB's
+        #   clientTransportRule option), e.g. "* unix,tcp"
+        # @param [Hash<String,#to_s>] orb_options other omniORB options, by
+        #   name (without the -ORB prefix)
+        #
+        # @example prefer unix sockets to talk to the processes of the same
+        #   machine
+        #   Runkit::CORBA.initialize(unix: true)
+        def self.initialize(
+            unix: false, endpoints: [], end_point_publish: nil,
+            client_transport_rules: [], orb_options: {}
+        )
             self.call_timeout    ||= 20_000
             self.connect_timeout ||= 2000
-            do_initialize
+
+            if unix
+                endpoints = ["giop:unix:", "giop:tcp::"] if endpoints.empty?
+                end_point_publish ||= "all(addr)"
+                client_transport_rules = ["* unix,tcp"] if client_transport_rules.empty?
+            end
+
+            args = []
+            endpoints.each { |e| args << "-ORBendPoint" << e }
+            args << "-ORBendPointPublish" << end_point_publish if end_point_publish
+            client_transport_rules.each { |r| args << "-ORBclientTransportRule" << r }
+            orb_options.each { |name, value| args << "-ORB#{name}" << value.to_s }
+            do_initialize(args)
+        end
+
+        # Serves a CORBA name service from this process
+        #
+        # The bindings are kept in memory, and are lost when the name service
+        # is stopped. This is meant for tests and benchmarks, which can then
+        # run without an omniNames process. Calling it again returns the
+        # address of the name service that is already running.
+        #
+        # @return [String] the address of the name service, to be given to
+        #   {NameServices::CORBA#initialize}
+        #
+        # @example
+        #   name_service = Runkit::NameServices::CORBA.new(
+        #       Runkit::CORBA.start_name_service
+        #   )
+        def self.start_name_service
+            do_start_name_service
+        end
+
+        # Stops the name service started by {.start_name_service}
+        def self.stop_name_service
+            do_stop_name_service
         end
 
         def self.clear
@@ -83,6 +177,8 @@ def self.clear
         def self.refine_exceptions(obj0, obj1 = nil) # :nodoc:
             yield
         rescue ComError => e
+            invalidate_proxy_of(obj0)
+            invalidate_proxy_of(obj1)
             if obj1
                 raise ComError,
                       "communication failed with either #{obj0} or #{obj1}",
@@ -91,5 +187,18 @@ def self.refine_exceptions(obj0, obj1 = nil) # :nodoc:
 
             raise ComError, "Communication failed with corba #{obj0}", e.backtrace
         end
+
+        # @api private
+        #
+        # Makes the next {TaskContext.new} for the task of the given object
+        # resolve it again, instead of reusing the existing proxy
+        #
+        # The task contexts are shared by IOR. This is called when a call
+        # fails with a communication error, as the remote object may not exist
+        # anymore
+        def self.invalidate_proxy_of(obj)
+            task = obj.respond_to?(:task) ? obj.task : obj
+            task.do_invalidate_proxy if task.kind_of?(TaskContext)
+        end
     end
 end
@@ -0,0 +1,22 @@
+# frozen_string_literal: true
+
+module Runkit
+    # Whether typelib arrays and std::vector of numeric values export their
+    # buffer through Ruby's MemoryView API
+    #
+    # When true, numeric libraries that support MemoryView (e.g. numo-narray
+    # or fiddle) can access the samples read from ports without copying
+    # them. Use {Runkit.sample_buffer} to get a frozen String sharing the
+    # same memory instead.
+    #
+    # The view shares the sample's memory. The sample must not be resized
+    # while the view is in use.
+    def self.memory_view_enabled?
+        @memory_view_enabled
+    end
+
+    @memory_view_enabled =
+        [Typelib::ArrayType, Typelib::ContainerType]
+        .map { |klass| do_register_memory_view(klass) }
+        .all?
+end
@@ -46,6 +46,19 @@ def names
                 raise NotImplementedError
             end
 
+            # Returns the names and IORs of all the Runkit Tasks known by the
+            # name service
+            #
+            # The names that cannot be resolved anymore are skipped
+            #
+            # @return [Hash<String,String>]
+            def resolve_all
+                names.each_with_object({}) do |name, result|
+                    result[name] = ior(name)
+                rescue NotFound # rubocop:disable Lint/SuppressedException
+                end
+            end
+
             # Checks if the name service is reachable if not it
             # raises a ComError.
             #
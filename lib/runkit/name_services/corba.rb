@@ -49,6 +49,36 @@ def names
                 []
             end
 
+            # (see NameServiceBase#resolve_all)
+            #
+            # The bindings are listed chunk_size at a time, and resolved in
+            # parallel, with the GVL released only once. The cost of discovering
+            # the tasks is therefore mostly independent of their number.
+            #
+            # @param [Integer] chunk_size the number of bindings listed at each
+            #   call to the name service
+            # @param [Integer] max_threads the maximum number of names resolved
+            #   concurrently. The names are resolved by the calling thread and
+            #   the worker pool, so it is clamped to
+            #   {CORBA.async_worker_count} + 1
+            # @raise [ArgumentError] if chunk_size or max_threads is lower than 1
+            def resolve_all(chunk_size: 100, max_threads: 16)
+                if chunk_size < 1
+                    raise ArgumentError,
+                          "chunk_size must be at least 1, got #{chunk_size}"
+                elsif max_threads < 1
+                    raise ArgumentError,
+                          "max_threads must be at least 1, got #{max_threads}"
+                end
+
+                Runkit::CORBA.refine_exceptions("corba naming service(#{ip})") do
+                    do_resolve_all(chunk_size, max_threads)
+                        .delete_if { |n, _| n =~ /^runkitrb_(\d+)$/ }
+                end
+            rescue NotFound
+                {}
+            end
+
             # (see NameServiceBase#get)
             def get(name, **options)
                 Runkit::TaskContext.new(ior(name), name: name, **options)
@@ -0,0 +1,133 @@
+# frozen_string_literal: true
+
+require "io/wait"
+
+module Runkit
+    module NameServices
+        class CORBA < Base
+            # Reports the task contexts that appear on or disappear from a
+            # CORBA name service
+            #
+            # The CORBA name service has no change notification. The watcher
+            # therefore lists the registered names periodically, but it does
+            # so in a native thread that keeps the last listing and only hands
+            # the differences to Ruby. Watching a name service with many tasks
+            # costs no Ruby work as long as nothing changes.
+            #
+            # The first listing reports all the names that are already
+            # registered as added.
+            #
+            # Instances are created with {CORBA#watch}
+            class Watcher
+                # A change on the name service
+                #
+                # @!attribute [r] kind
+                #   @return [Symbol] either :added or :removed
+                # @!attribute [r] name
+                #   @return [String] the task name
+                Change = Struct.new(:kind, :name) do
+                    def added?
+                        kind == :added
+                    end
+
+                    def removed?
+                        kind == :removed
+                    end
+                end
+
+                # The cost of the polling done by the watcher
+                #
+                # @!attribute [r] polls
+                #   @return [Integer] the number of times the name service got
+                #     listed
+                # @!attribute [r] errors
+                #   @return [Integer] the number of listings that failed
+                # @!attribute [r] last_duration
+                #   @return [Float] the duration of the last listing, in seconds
+                # @!attribute [r] total_duration
+                #   @return [Float] the cumulated duration of all the listings,
+                #     in seconds
+                # @!attribute [r] name_count
+                #   @return [Integer] the number of names in the last
+                #     successful listing
+                # @!attribute [r] last_error
+                #   @return [String,nil] the error of the last failed listing
+                Stats = Struct.new(
+                    :polls, :errors, :last_duration, :total_duration,
+                    :name_count, :last_error, keyword_init: true
+                ) do
+                    # The average duration of a listing, in seconds
+                    def average_duration
+                        polls == 0 ? 0 : total_duration / polls
+                    end
+                end
+
+                # @return [CORBA] the name service being watched
+                attr_accessor :name_service
+
+                # Returns the changes that happened since the last call, without
+                # waiting
+                #
+                # @return [Array<Change>]
+                def changes
+                    do_pop_changes.each_with_object([]) do |(added, name), result|
+                        next if name =~ /^runkitrb_(\d+)$/
+
+                        result << Change.new(added ? :added : :removed, name)
+                    end
+                end
+
+                # Waits for changes and returns them
+                #
+                # When a Fiber scheduler is active, only the calling fiber
+                # waits. Otherwise, the calling thread is blocked.
+                #
+                # @param [Numeric,nil] timeout how long to wait in seconds.
+                #   Waits until there are changes if nil.
+                # @return [Array<Change>] the changes, which is empty if the
+                #   timeout expired
+                def pop(timeout: nil)
+                    notification_io.wait_readable(timeout)
+                    changes
+                end
+
+                # The IO that becomes readable when there are changes, for
+                # integration in an event loop
+                #
+                # @return [IO]
+                def notification_io
+                    @notification_io ||=
+                        IO.for_fd(do_notification_fd, autoclose: false)
+                end
+
+                # @return [Stats] the cost of the polling so far
+                def stats
+                    Stats.new(**do_stats)
+                end
+
+                # Stops the watcher thread
+                #
+                # The watcher thread is also stopped when this object is
+                # garbage collected
+                def stop
+                    do_stop
+                end
+            end
+
+            # Watches the task contexts registered on this name service
+            #
+            # @param [Numeric] period the time between two listings of the
+            #   name service, in seconds
+            # @param [Integer] chunk_size the number of bindings listed at each
+            #   call to the name service
+            # @return [Watcher]
+            def watch(period: 1, chunk_size: 100)
+                watcher = Runkit::CORBA.refine_exceptions("corba naming service(#{ip})") do
+                    do_watch(Integer(period * 1000), chunk_size)
+                end
+                watcher.name_service = self
+                watcher
+            end
+        end
+    end
+end
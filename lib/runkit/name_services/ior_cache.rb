@@ -0,0 +1,237 @@
+# frozen_string_literal: true
+
+require "fileutils"
+require "json"
+require "tempfile"
+
+module Runkit
+    module NameServices
+        # Name service that caches on disk the IORs resolved by another name
+        # service
+        #
+        # Tools that attach to a running system resolve the same tasks every
+        # time they are started. This name service remembers the IOR of the
+        # tasks, and optionally the model of their interface, so that starting
+        # again does not need any name service round trip nor interface
+        # discovery.
+        #
+        # The cache is a JSON file, which can be shared by many processes.
+        # Concurrent updates are serialized by a lock on a separate
+        # `<path>.lock` file.
+        #
+        # Cached IORs are validated lazily. {#ior} checks that the object still
+        # exists with a single `_non_existent` call, and {#get} uses the cached
+        # IOR directly, resolving the task again through the backend if
+        # creating the {TaskContext} fails with a communication error.
+        #
+        # @example use a cache in front of the CORBA name service
+        #   cache = Runkit::NameServices::IORCache.new(
+        #       Runkit::NameServices::CORBA.new, introspect: true
+        #   )
+        #   task = cache.get("camera")
+        class IORCache < Base
+            # The default location of the cache file
+            #
+            # It is $RUNKIT_IOR_CACHE if set, and runkit/ior_cache in the XDG
+            # cache directory otherwise
+            def self.default_path
+                if (path = ENV["RUNKIT_IOR_CACHE"])
+                    return path
+                end
+
+                cache_dir = ENV["XDG_CACHE_HOME"] || File.join(Dir.home, ".cache")
+                File.join(cache_dir, "runkit", "ior_cache")
+            end
+
+            # @return [Base] the name service used to resolve the names that
+            #   are not in the cache
+            attr_reader :backend
+
+            # @return [String] the path of the cache file
+            attr_reader :path
+
+            # @return [String] the key under which the entries of this backend
+            #   are stored in the cache file, which may be shared by many
+            #   backends
+            attr_reader :scope
+
+            # @param [Base] backend the name service used to resolve the names
+            #   that are not in the cache
+            # @param [String] path the path of the cache file
+            # @param [String] scope the key under which the entries of this
+            #   backend are stored in the cache file. It defaults to the
+            #   backend's class and IP, if it has one
+            # @param [Boolean] introspect whether {#get} should cache the model
+            #   of the task interface (see {TaskContext#introspect}) as well
+            def initialize(
+                backend, path: IORCache.default_path,
+                scope: IORCache.default_scope(backend), introspect: false
+            )
+                @backend = backend
+                @path = path
+                @scope = scope
+                @introspect = introspect
+                @entries = nil
+            end
+
+            # @api private
+            #
+            # Default value for the scope: argument of {#initialize}
+            def self.default_scope(backend)
+                if backend.respond_to?(:ip)
+                    "#{backend.class.name}:#{backend.ip}"
+                else
+                    backend.class.name
+                end
+            end
+
+            # (see Base#names)
+            def names
+                backend.names
+            end
+
+            # (see Base#ior)
+            #
+            # A cached IOR is returned only if the object it refers to still
+            # exists
+            def ior(name)
+                if (entry = entries[name])
+                    return entry[:ior] unless Runkit::CORBA.do_non_existent?(entry[:ior])
+
+                    invalidate(name)
+                end
+
+                resolve(name)[:ior]
+            end
+
+            # (see Base#get)
+            def get(name, **options)
+                if (entry = entries[name])
+                    begin
+                        return task_from_entry(name, entry, **options)
+                    rescue ComError
+                        invalidate(name)
+                    end
+                end
+
+                task_from_entry(name, resolve(name), **options)
+            end
+
+            # Removes a name from the cache
+            def invalidate(name)
+                return unless entries.delete(name)
+
+                save
+            end
+
+            # Removes all the names of this cache's scope
+            def clear
+                return if entries.empty?
+
+                entries.clear
+                save
+            end
+
+            # (see Base#cleanup)
+            def cleanup
+                backend.cleanup if backend.respond_to?(:cleanup)
+                clear
+            end
+
+            def to_s
+                "#<IORCache #{path} #{backend}>"
+            end
+
+            private
+
+            # The cache entries of this cache's scope, loaded on first access
+            #
+            # @return [Hash<String,Hash>]
+            def entries
+                @entries ||= load_entries
+            end
+
+            # Reads the entries of this cache's scope from the cache file
+            #
+            # Malformed entries are ignored
+            def load_entries
+                scope_entries = load_file[scope]
+                return {} unless scope_entries.kind_of?(Hash)
+
+                scope_entries.each_with_object({}) do |(name, entry), result|
+                    next unless entry.kind_of?(Hash) && entry["ior"].kind_of?(String)
+
+                    result[name] = { ior: entry["ior"] }
+                    if (model = entry["model"]).kind_of?(Hash)
+                        result[name][:model] = model.transform_keys(&:to_sym)
+                    end
+                end
+            end
+
+            def load_file
+                all = JSON.parse(File.read(path))
+                all.kind_of?(Hash) ? all : {}
+            rescue StandardError
+                {}
+            end
+
+            # Writes the cache file, merging the entries of the other scopes
+            # that are present in the file
+            #
+            # The file is replaced atomically, so that concurrent processes
+            # never read a partial file, and the read-merge-write sequence is
+            # done under an exclusive lock, so that they do not lose each
+            # other's updates
+            def save
+                FileUtils.mkdir_p(File.dirname(path))
+                File.open("#{path}.lock", File::RDWR | File::CREAT, 0o644) do |lock|
+                    lock.flock(File::LOCK_EX)
+                    all = load_file
+                    all[scope] = entries
+                    write_file(JSON.generate(all))
+                end
+            rescue SystemCallError => e
+                Runkit.warn "failed to save the IOR cache #{path}: #{e.message}"
+            end
+
+            # Atomically replaces the cache file with the given content
+            def write_file(content)
+                tmp = Tempfile.create([File.basename(path), ".tmp"], File.dirname(path))
+                begin
+                    tmp.write(content)
+                    tmp.close
+                    File.rename(tmp.path, path)
+                rescue StandardError
+                    tmp.close unless tmp.closed?
+                    FileUtils.rm_f(tmp.path)
+                    raise
+                end
+            end
+
+            # Resolves a name with the backend and caches it
+            def resolve(name)
+                entry = { ior: backend.ior(name) }
+                entries[name] = entry
+                save
+                entry
+            end
+
+            def task_from_entry(name, entry, **options)
+                if (snapshot = entry[:model]) && !options.key?(:model)
+                    options[:model] = TaskContext.model_from_introspection(
+                        name, snapshot,
+                        loader: options[:loader] || Runkit.default_loader
+                    )
+                end
+
+                task = TaskContext.new(entry[:ior], name: name, **options)
+                if @introspect && !entry[:model]
+                    entry[:model] =
+                        Runkit::CORBA.refine_exceptions(task) { task.do_introspect }
+                    save
+                end
+                task
+            end
+        end
+    end
+end
@@ -172,25 +172,68 @@ def sendop(*args)
 
         # Calls the method with the provided arguments, waiting for the method
         # to finish. It returns the value returned by the remote method.
-        def callop(*args)
+        #
+        # @param [Numeric,nil] timeout the call timeout in seconds, see
+        #   {CORBA.with_call_timeout}
+        def callop(*args, timeout: nil)
             raw_result = common_call(args) do |filtered|
-                return_typename, return_value = nil
-                unless @void_return
-                    return_typename = orocos_return_typenames[0]
-                    return_value = result_value_for(return_types.first)
+                return_typename, return_value = call_result_for
+
+                CORBA.with_call_timeout(timeout) do
+                    task.do_operation_call(name, return_typename, return_value,
+                                           orocos_arguments_typenames, filtered)
                 end
+                raw_call_result(return_value, filtered)
+            end
 
-                task.do_operation_call(name, return_typename, return_value,
-                                       orocos_arguments_typenames, filtered)
+            format_call_result(raw_result)
+        end
 
-                result = []
-                result << return_value if return_value
-                inout_arguments.each do |index|
-                    result << filtered[index]
+        # Calls the method in the background
+        #
+        # The arguments are converted right away, the call itself is done by
+        # one of the async workers
+        #
+        # @return [AsyncCall] a call whose value is the value returned by the
+        #   remote method, as returned by {#callop}
+        def callop_async(*args)
+            common_call(args) do |filtered|
+                return_typename, return_value = call_result_for
+                task.do_operation_call_async(
+                    name, return_typename, return_value,
+                    orocos_arguments_typenames, filtered
+                ).setup(self) do
+                    format_call_result(raw_call_result(return_value, filtered))
                 end
-                result
             end
+        end
+
+        # @api private
+        #
+        # Returns the return type name and a value to store the result of a
+        # call, or nil if the method returns nothing
+        def call_result_for
+            return if @void_return
+
+            [orocos_return_typenames[0], result_value_for(return_types.first)]
+        end
+
+        # @api private
+        #
+        # Gathers the return value and the inout arguments of a call
+        def raw_call_result(return_value, filtered)
+            result = []
+            result << return_value if return_value
+            inout_arguments.each do |index|
+                result << filtered[index]
+            end
+            result
+        end
 
+        # @api private
+        #
+        # Converts the raw result of a call into what {#callop} returns
+        def format_call_result(raw_result)
             result = []
             raw_result.each_with_index do |v, i|
                 result << Typelib.to_ruby(v, return_types[i])
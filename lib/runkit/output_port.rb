@@ -1,6 +1,94 @@
 # frozen_string_literal: true
 
 module Runkit
+    # Creates many connections at once
+    #
+    # Each distinct policy is converted only once, and the connections are
+    # created in parallel with the GVL released only once. At most a few
+    # connections are created concurrently on the same output task. A
+    # connection that fails does not prevent creating the others.
+    #
+    # @param [Array<(OutputPort,InputPort,Hash)>] edges the connections, as
+    #   output port, input port and connection policy (see
+    #   {OutputPort#connect_to})
+    # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+    #   {CORBA.with_call_timeout}
+    # @return [Array<true,Exception>] for each connection, either true or
+    #   the error that prevented its creation
+    def self.connect_all(edges, timeout: nil)
+        edges = edges.map do |out_port, in_port, policy|
+            out_port = out_port.to_runkit_port
+            in_port = in_port.to_runkit_port
+            if !in_port.kind_of?(InputPort)
+                raise ArgumentError, "an output port can only connect to an input port (got #{in_port})"
+            elsif in_port.type.name != out_port.type.name
+                raise ArgumentError, "trying to connect #{out_port}, an output port of type #{out_port.type.name}, to #{in_port}, an input port of type #{in_port.type.name}"
+            end
+
+            policy = Port.prepare_policy(**(policy || {}))
+            in_port.blocking_read = true if policy[:pull]
+            [out_port, in_port, policy]
+        end
+
+        results = CORBA.with_call_timeout(timeout) { do_connect_all(edges) }
+        edges.zip(results).map do |(out_port, in_port, policy), result|
+            next result if result == true
+
+            message = "failed to connect #{out_port.full_name} => "\
+                      "#{in_port.full_name} with policy #{policy.inspect}"
+            if result.kind_of?(Exception)
+                result.exception("#{message}: #{result.message}")
+            else
+                ConnectionFailed.new(message)
+            end
+        end
+    end
+
+    # Removes many connections at once
+    #
+    # This is the batched version of {OutputPort#disconnect_from}
+    #
+    # @param [Array<(OutputPort,InputPort)>] edges
+    # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+    #   {CORBA.with_call_timeout}
+    # @return [Array<Boolean,Exception>] for each pair of ports, either
+    #   whether they were connected, or the error raised while
+    #   disconnecting them
+    def self.disconnect_all(edges, timeout: nil)
+        edges = edges.map do |out_port, in_port|
+            [out_port.to_runkit_port, in_port.to_runkit_port]
+        end
+        CORBA.with_call_timeout(timeout) { do_disconnect_all(edges) }
+    end
+
+    # Removes all the connections of many ports at once
+    #
+    # This is the batched version of {Port#disconnect_all}
+    #
+    # @param [Array<Port>] ports
+    # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+    #   {CORBA.with_call_timeout}
+    # @return [Array<true,Exception>] for each port, either true or the error
+    #   raised while disconnecting it
+    def self.disconnect_ports(ports, timeout: nil)
+        ports = ports.map(&:to_runkit_port)
+        CORBA.with_call_timeout(timeout) { do_disconnect_ports(ports) }
+    end
+
+    # Tests whether many ports are connected at once
+    #
+    # This is the batched version of {Port#connected?}
+    #
+    # @param [Array<Port>] ports
+    # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+    #   {CORBA.with_call_timeout}
+    # @return [Array<Boolean,Exception>] for each port, either whether it is
+    #   connected or the error raised while querying it
+    def self.connected_all(ports, timeout: nil)
+        ports = ports.map(&:to_runkit_port)
+        CORBA.with_call_timeout(timeout) { do_connected_all(ports) }
+    end
+
     # This class represents output ports on remote task contexts.
     #
     # They are obtained from TaskContext#port or TaskContext#each_port
@@ -46,7 +134,10 @@ def input?
         # Where the +size+ option gives the size of the intermediate buffer.
         # Note that new samples will be lost if they are received when the
         # buffer is full.
-        def connect_to(input_port, distance: D_UNKNOWN, **options)
+        #
+        # The timeout: option sets the timeout of the CORBA calls made to
+        # create the connection, in seconds (see {CORBA.with_call_timeout})
+        def connect_to(input_port, distance: D_UNKNOWN, timeout: nil, **options)
             return super unless input_port.respond_to?(:to_runkit_port)
 
             input_port = input_port.to_runkit_port
@@ -63,8 +154,10 @@ def connect_to(input_port, distance: D_UNKNOWN, **options)
             input_port.blocking_read = true if policy[:pull]
 
             begin
-                refine_exceptions(input_port) do
-                    do_connect_to(input_port, policy)
+                CORBA.with_call_timeout(timeout) do
+                    refine_exceptions(input_port) do
+                        do_connect_to(input_port, policy)
+                    end
                 end
             rescue Runkit::ConnectionFailed
                 if policy[:transport] == TRANSPORT_MQ && Runkit::MQueue.auto_fallback_to_corba?
@@ -8,6 +8,7 @@ def log_metadata
         end
 
         def do_write(type_name, value, direct: false)
+            task.property_cache.delete(name)
             if !direct && dynamic?
                 do_write_dynamic(value)
             else
@@ -18,5 +19,14 @@ def do_write(type_name, value, direct: false)
         def do_read(type_name, value)
             task.do_property_read(name, type_name, value)
         end
+
+        # Reads the property's value in the background
+        #
+        # @return [AsyncCall] a call whose value is the property's value, as
+        #   returned by {#read}
+        def read_async
+            task.do_property_read_async(name, runkit_type_name, type.new)
+                .setup(self) { |value| Typelib.to_ruby(value) }
+        end
     end
 end
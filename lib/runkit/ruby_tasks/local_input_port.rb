@@ -1,6 +1,43 @@
 # frozen_string_literal: true
 
 module Runkit
+    # Waits until one of the given local input ports has new data
+    #
+    # Unlike calling {RubyTasks::LocalInputPort#read_new} on each port in a
+    # loop, the GVL is released only once for the whole set. The ports'
+    # {RubyTasks::LocalInputPort#notification_io} are enabled as needed, and
+    # the notifications of the ready ports are cleared before returning.
+    #
+    # Only data that arrives after a port's notification is enabled wakes the
+    # call up. Read the ports once after the first call to get data that was
+    # already queued.
+    #
+    # @param [Array<RubyTasks::LocalInputPort>] readers
+    # @param [Numeric,nil] timeout how long to wait in seconds, nil to wait
+    #   forever
+    # @return [Array<RubyTasks::LocalInputPort>] the ports that have new
+    #   data, empty if the timeout expired
+    def self.wait_any(readers, timeout: nil)
+        fds = readers.map { |port| port.notification_io.fileno }
+        deadline = Time.now + timeout if timeout
+
+        loop do
+            timeout_ms =
+                if deadline
+                    [((deadline - Time.now) * 1000).ceil, 0].max
+                else
+                    -1
+                end
+
+            ready = RubyTasks::LocalInputPort.do_wait_any(fds, timeout_ms)
+            next unless ready # interrupted by a signal
+
+            ready_ports = ready.map { |i| readers[i] }
+            ready_ports.each(&:clear_notification)
+            return ready_ports
+        end
+    end
+
     module RubyTasks
         # Input port created on a {TaskContext} task instantiated in this Ruby
         # process
@@ -12,6 +49,52 @@ def remove
                 task.remove_port(self)
             end
 
+            # An IO that becomes readable when new data arrives on this port
+            #
+            # It is meant to be used with IO.select, or with a Fiber scheduler,
+            # to wait on many ports at once instead of polling them. Once it
+            # is readable, call {#clear_notification} before reading the
+            # samples, so that data arriving in between is not missed.
+            #
+            # Each sample that arrives writes its arrival time to the IO, as
+            # a native 64 bit integer holding the CLOCK_MONOTONIC time in
+            # nanoseconds (use `unpack("q*")`). {StateSubscription} uses it to
+            # measure its dispatch latency. Callers that only wait on the IO
+            # can ignore the content.
+            #
+            # The underlying file descriptor is created on the first call. The
+            # IO owns it, and is closed when the port is removed or
+            # {#disable_notification} is called
+            #
+            # @return [IO]
+            def notification_io
+                @notification_io ||= IO.for_fd(do_enable_notification)
+            end
+
+            # Whether {#notification_io} has been created
+            def notification_enabled?
+                @notification_io ? true : false
+            end
+
+            # Reset {#notification_io} so that it is not readable anymore
+            def clear_notification
+                return unless @notification_io
+
+                loop do
+                    data = @notification_io.read_nonblock(1024, exception: false)
+                    break unless data.kind_of?(String)
+                end
+            end
+
+            # Stop notifying data arrival and close {#notification_io}
+            def disable_notification
+                return unless @notification_io
+
+                do_disable_notification
+                @notification_io.close
+                @notification_io = nil
+            end
+
             # Reads a sample on this input port
             #
             # For simple types, the returned value is the Ruby representation of the
@@ -142,7 +225,7 @@ def raw_read_with_result(sample = nil, copy_old_data = true)
                 end
 
                 result = value.allocating_operation do
-                    do_read(runkit_type_name, value, copy_old_data, blocking_read?)
+                    do_read(value, copy_old_data, blocking_read?)
                 end
                 if result == NEW_DATA || (result == OLD_DATA && copy_old_data)
                     sample&.invalidate_changes_from_converted_types
@@ -152,6 +235,59 @@ def raw_read_with_result(sample = nil, copy_old_data = true)
                 end
             end
 
+            # Creates a buffer that can be given to {#drain}
+            #
+            # @param [Integer] size the maximum number of samples {#drain} will
+            #   read in one call
+            # @return [Typelib::ArrayType]
+            def new_drain_buffer(size)
+                type.registry.build("#{type.name}[#{size}]").new
+            end
+
+            # Reads all new samples queued on this port in a single call
+            #
+            # This is meant to be used on buffered connections, to avoid
+            # calling {#read_new} in a loop. Samples are read in order at the
+            # beginning of the buffer. The buffer can be reused across calls.
+            #
+            # @param [Typelib::ArrayType] buffer the array the samples should be
+            #   read into, usually created with {#new_drain_buffer}
+            # @return [Integer] the number of samples read
+            def drain(buffer)
+                if buffer.class.deference != type
+                    raise ArgumentError,
+                          "wrong buffer type #{buffer.class}, expected an array of #{type}"
+                end
+
+                count =
+                    if blocking_read?
+                        # Pull connections need to release the GVL on each
+                        # read, let do_read handle it. buffer[i] would be the
+                        # converted Ruby value for converted types, read into
+                        # the Typelib element instead
+                        buffer.allocating_operation do
+                            buffer.size.times.find do |i|
+                                do_read(buffer.raw_get(i), false, true) != NEW_DATA
+                            end || buffer.size
+                        end
+                    else
+                        buffer.allocating_operation { do_drain(buffer) }
+                    end
+                buffer.invalidate_changes_from_converted_types
+                count
+            end
+
+            # Reads all new samples queued on this port, up to a maximum
+            #
+            # @param [Integer] max the maximum number of samples to read
+            # @return [Array] the samples, converted to their Ruby
+            #   representation
+            def read_all(max = 100)
+                buffer = new_drain_buffer(max)
+                count = drain(buffer)
+                Array.new(count) { |i| Typelib.to_ruby(buffer[i]) }
+            end
+
             # Clears the channel, i.e. "forget" that this port ever got written to
             def clear
                 do_clear
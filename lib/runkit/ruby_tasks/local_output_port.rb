@@ -28,7 +28,33 @@ def remove
             #   input_writer.write(:field => 10, :other_field => "a_string")
             def write(data)
                 data = Typelib.from_ruby(data, type)
-                do_write(runkit_type_name, data)
+                do_write(data)
+            end
+
+            # Write several samples in a single call
+            #
+            # The samples are marshalled and written in order, without
+            # returning to Ruby between samples.
+            #
+            # @param [Typelib::ArrayType,Typelib::ContainerType,Array] samples
+            #   the samples. Typelib arrays of this port's type are written
+            #   as-is, other collections are first copied into such an array
+            # @return [Integer] the number of samples that have been accepted
+            #   by the port's connections
+            def write_many(samples)
+                if samples.kind_of?(Typelib::ArrayType) &&
+                   samples.class.deference == type
+                    return do_write_many(samples, samples.size)
+                end
+
+                samples = samples.to_a
+                return 0 if samples.empty?
+
+                buffer = write_buffer(samples.size)
+                samples.each_with_index do |s, i|
+                    buffer[i] = Typelib.from_ruby(s, type)
+                end
+                do_write_many(buffer, samples.size)
             end
 
             # Whether the port seem to be connected to something
@@ -37,6 +63,25 @@ def connected?
                     super
                 end
             end
+
+            private
+
+            # @api private
+            #
+            # Returns the typelib array used by {#write_many} to marshal
+            # collections of samples
+            #
+            # The array is kept between calls and replaced only when it is too
+            # small. Its size grows by powers of two, which bounds the number
+            # of array types registered in the port type's registry
+            def write_buffer(size)
+                return @write_buffer if @write_buffer && @write_buffer.size >= size
+
+                capacity = 1
+                capacity *= 2 while capacity < size
+                @write_buffer =
+                    type.registry.build("#{type.name}[#{capacity}]").new
+            end
         end
     end
 end
@@ -87,7 +87,7 @@ def initialize(name, task_context)
                     @task_context = task_context
                 end
 
-                def callop(*args)
+                def callop(*args, timeout: nil) # rubocop:disable Lint/UnusedMethodArgument
                     task_context.send(name, *args)
                 end
 
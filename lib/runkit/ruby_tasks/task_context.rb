@@ -109,6 +109,7 @@ def create_output_port(name, type, **options)
             def remove_port(port)
                 @local_ports.delete(port.name)
                 port.disconnect_all # don't wait for the port to be garbage collected by Ruby
+                port.disable_notification if port.respond_to?(:disable_notification)
                 @local_task.do_remove_port(port.name)
             end
 
@@ -118,6 +119,7 @@ def remove_port(port)
             # However, it is sometimes better to do this explicitely, for instance
             # to avoid the name clash warning.
             def dispose
+                do_invalidate_proxy
                 @local_task.dispose
             end
 
@@ -0,0 +1,296 @@
+# frozen_string_literal: true
+
+module Runkit
+    # Push-based monitoring of the state of a task
+    #
+    # A subscription connects a single buffered reader to the task's state
+    # port, and dispatches all the states the task goes through to callbacks
+    # and queues. Unlike polling {TaskContext#read_toplevel_state}, it does not
+    # need one round trip per check, and does not miss transient states as
+    # long as the reader's buffer does not overflow between two dispatches.
+    #
+    # Subscriptions are created and dispatched by {StateSubscriptions},
+    # usually through {TaskContext#on_state_change}
+    class StateSubscription
+        # A state change, as passed to the callbacks and pushed to the queues
+        #
+        # @!attribute [r] task
+        #   @return [TaskContext]
+        # @!attribute [r] state
+        #   @return [Symbol]
+        # @!attribute [r] latency
+        #   @return [Float,nil] the time in seconds between the first state of
+        #     the dispatched batch reaching the local reader and the dispatch.
+        #     It is nil if the batch only contains states that were already
+        #     queued when the subscription was created
+        Transition = Struct.new(:task, :state, :latency)
+
+        # The task whose state is monitored
+        #
+        # @return [TaskContext]
+        attr_reader :task
+
+        # The reader connected to the task's state port
+        #
+        # @return [OutputReader]
+        attr_reader :reader
+
+        def initialize(task, buffer_size: 100)
+            @task = task
+            @reader = task.port("state").reader(
+                type: :buffer, size: buffer_size, init: true
+            )
+            @buffer = @reader.new_drain_buffer(buffer_size)
+            @callbacks = []
+            @queues = []
+
+            # Data is only notified once notifications are enabled. Read what
+            # is already queued afterwards, so that nothing falls in between
+            @reader.notification_io
+            @pending = read_states
+        end
+
+        # @api private
+        #
+        # Whether states have been read, but not dispatched yet
+        def pending?
+            !@pending.empty?
+        end
+
+        # Registers a block called with a {Transition} for each state change
+        #
+        # The block is called from the thread that dispatches the
+        # subscriptions
+        #
+        # @return [Object] the block, to be given to {#remove}
+        def on_change(&block)
+            @callbacks << block
+            block
+        end
+
+        # Pushes a {Transition} to the given queue for each state change
+        #
+        # @param [#<<] queue
+        # @return [Object] the queue, to be given to {#remove}
+        def push_to(queue)
+            @queues << queue
+            queue
+        end
+
+        # Removes a callback or queue registered with {#on_change} or
+        # {#push_to}
+        def remove(callback_or_queue)
+            @callbacks.delete(callback_or_queue)
+            @queues.delete(callback_or_queue)
+        end
+
+        # Whether there are no callbacks and no queues left
+        def empty?
+            @callbacks.empty? && @queues.empty?
+        end
+
+        # Disconnects the reader from the task's state port
+        def dispose
+            @reader.disconnect
+            @reader.remove
+        end
+
+        # Reads the states the task went through since the last call, and
+        # passes them to the callbacks and queues
+        #
+        # @return [Array<Transition>] the transitions that have been dispatched
+        def dispatch
+            notify(read_transitions)
+        end
+
+        # @api private
+        #
+        # Reads the states the task went through since the last call
+        #
+        # @return [Array<Transition>]
+        def read_transitions
+            arrival = read_first_arrival_time
+            states = @pending + read_states
+            @pending = []
+            return [] if states.empty?
+
+            latency =
+                if arrival
+                    now = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond)
+                    (now - arrival) / 1e9
+                end
+            states.map { |s| Transition.new(task, s, latency) }
+        end
+
+        # @api private
+        #
+        # Passes transitions to the callbacks and queues
+        #
+        # @return [Array<Transition>] the transitions
+        def notify(transitions)
+            callbacks = @callbacks.dup
+            queues = @queues.dup
+            transitions.each do |t|
+                callbacks.each { |c| c.call(t) }
+                queues.each { |q| q << t }
+            end
+            transitions
+        end
+
+        private
+
+        # Reads the arrival times written to the notification pipe, and returns
+        # the oldest one
+        def read_first_arrival_time
+            data = +""
+            loop do
+                chunk = @reader.notification_io.read_nonblock(4096, exception: false)
+                break unless chunk.kind_of?(String)
+
+                data << chunk
+            end
+            data.unpack("q*").min
+        end
+
+        def read_states
+            states = []
+            loop do
+                count = @reader.drain(@buffer)
+                count.times do |i|
+                    states << task.map_state_value_to_symbol(Typelib.to_ruby(@buffer[i]))
+                end
+                break if count < @buffer.size
+            end
+            states
+        end
+    end
+
+    # Dispatches the state subscriptions of many tasks
+    #
+    # Dispatching waits on all the subscriptions' readers at once (see
+    # {Runkit.wait_any}). Call {#dispatch} from an existing event loop, or
+    # {#start} to dispatch from a background thread.
+    class StateSubscriptions
+        def initialize
+            @subscriptions = {}
+            @mutex = Mutex.new
+        end
+
+        # Registers a callback or a queue to be notified of a task's state
+        # changes
+        #
+        # All the subscriptions to the same task share a single reader
+        #
+        # @param [TaskContext] task
+        # @param [#<<,nil] queue a queue to which the {StateSubscription::Transition}
+        #   objects are pushed
+        # @param [Integer] buffer_size the size of the reader's buffer, only used
+        #   when creating the task's reader
+        # @yieldparam [StateSubscription::Transition] transition
+        # @return [Object] the object to be passed to {#unsubscribe}
+        def subscribe(task, queue: nil, buffer_size: 100, &block)
+            if !queue && !block
+                raise ArgumentError, "expected either a queue or a block"
+            end
+
+            @mutex.synchronize do
+                subscription =
+                    (@subscriptions[task] ||=
+                         StateSubscription.new(task, buffer_size: buffer_size))
+                queue ? subscription.push_to(queue) : subscription.on_change(&block)
+            end
+        end
+
+        # Removes a callback or queue registered with {#subscribe}
+        #
+        # The task's reader is disposed of when its last callback or queue is
+        # removed
+        def unsubscribe(task, callback_or_queue)
+            @mutex.synchronize do
+                return unless (subscription = @subscriptions[task])
+
+                subscription.remove(callback_or_queue)
+                if subscription.empty?
+                    @subscriptions.delete(task)
+                    subscription.dispose
+                end
+            end
+        end
+
+        # Whether some tasks are being monitored
+        def empty?
+            @mutex.synchronize { @subscriptions.empty? }
+        end
+
+        # Waits for state changes on the subscribed tasks and dispatches them
+        #
+        # The callbacks are called from the calling thread, and may call
+        # {#subscribe} and {#unsubscribe}
+        #
+        # @param [Numeric,nil] timeout how long to wait for a change in seconds,
+        #   nil to wait until one happens
+        # @return [Array<StateSubscription::Transition>] the transitions that
+        #   have been dispatched
+        def dispatch(timeout: 0)
+            subscriptions, fds, ready = @mutex.synchronize do
+                subscriptions = @subscriptions.values
+                [subscriptions,
+                 subscriptions.map { |s| s.reader.notification_io.fileno },
+                 subscriptions.select(&:pending?)]
+            end
+            return [] if subscriptions.empty?
+
+            # Wait without holding the lock, so that subscribe and unsubscribe
+            # are not blocked until a state changes
+            timeout = 0 unless ready.empty?
+            timeout_ms = timeout ? (timeout * 1000).ceil : -1
+            indexes = RubyTasks::LocalInputPort.do_wait_any(fds, timeout_ms) || []
+            ready |= indexes.map { |i| subscriptions[i] }
+
+            transitions = @mutex.synchronize do
+                # Subscriptions removed while waiting have been disposed of
+                current = @subscriptions.values
+                ready.find_all { |s| current.include?(s) }
+                     .map { |s| [s, s.read_transitions] }
+            end
+
+            transitions.flat_map { |s, t| s.notify(t) }
+        end
+
+        # Starts a thread that dispatches the subscriptions in a loop
+        #
+        # @param [Numeric] period how often the thread checks for subscriptions
+        #   added since the last dispatch
+        def start(period: 0.1)
+            return if @thread
+
+            @quit = false
+            @thread = Thread.new do
+                until @quit
+                    if empty?
+                        sleep period
+                    else
+                        dispatch(timeout: period)
+                    end
+                end
+            end
+        end
+
+        # Stops the thread started by {#start}
+        def stop
+            return unless @thread
+
+            @quit = true
+            @thread.join
+            @thread = nil
+        end
+    end
+
+    # The object that manages the subscriptions created by
+    # {TaskContext#on_state_change}
+    #
+    # @return [StateSubscriptions]
+    def self.state_subscriptions
+        @state_subscriptions ||= StateSubscriptions.new
+    end
+end
@@ -1,6 +1,31 @@
 # frozen_string_literal: true
 
 module Runkit
+    # Reads the state of many tasks at once
+    #
+    # All the calls are made in parallel, with the GVL released only once.
+    # A task that cannot be reached does not prevent reading the others'
+    # state: its entry in the returned hash is the error that was raised while
+    # reading it.
+    #
+    # @param [Array<TaskContext>] tasks
+    # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+    #   {CORBA.with_call_timeout}
+    # @return [Hash<TaskContext,Symbol|Exception>] for each task, either its
+    #   state (as returned by {TaskContext#read_toplevel_state}) or the error
+    def self.states_of(tasks, timeout: nil)
+        tasks = tasks.to_a
+        states = CORBA.with_call_timeout(timeout) { do_states_of(tasks) }
+        tasks.zip(states).each_with_object({}) do |(task, state), result|
+            result[task] =
+                if state.kind_of?(Exception)
+                    state
+                else
+                    task.map_state_value_to_symbol(state)
+                end
+        end
+    end
+
     # A proxy for a remote task context. The communication between Ruby and the
     # RTT component is done through the CORBA transport.
     #
@@ -17,11 +42,14 @@ class TaskContext < TaskContextBase
         # @api private
         #
         # Automated wrapper to handle CORBA exceptions coming from the C
-        # extension
+        # extension. The generated method accepts a timeout: keyword, which
+        # is passed to {CORBA.with_call_timeout}
         def self.corba_wrap(name, *args) # :nodoc:
             class_eval <<~DEF_END, __FILE__, __LINE__ + 1
-                def #{name}(#{args.join('. ')})
-                    CORBA.refine_exceptions(self) { do_#{name}(#{args.join(', ')}) }
+                def #{name}(#{(args + ['timeout: nil']).join(', ')})
+                    CORBA.with_call_timeout(timeout) do
+                        CORBA.refine_exceptions(self) { do_#{name}(#{args.join(', ')}) }
+                    end
                 end
             DEF_END
         end
@@ -97,6 +125,21 @@ def state_reader(distance: PortBase::D_UNKNOWN, **policy)
             reader
         end
 
+        # Calls a block or fills a queue with all the state changes of this task
+        #
+        # Unlike {#state_reader}, all the subscriptions of a task share a
+        # single reader, and are dispatched by {Runkit.state_subscriptions}
+        # (see {StateSubscriptions#dispatch} and {StateSubscriptions#start})
+        #
+        # @param (see StateSubscriptions#subscribe)
+        # @yieldparam (see StateSubscriptions#subscribe)
+        # @return (see StateSubscriptions#subscribe)
+        def on_state_change(queue: nil, buffer_size: 100, &block)
+            Runkit.state_subscriptions.subscribe(
+                self, queue: queue, buffer_size: buffer_size, &block
+            )
+        end
+
         # Returns the PID of the thread this task runs on
         #
         # This is available only on oroGen task, for which oroGen adds an
@@ -106,11 +149,25 @@ def tid
         end
 
         # Reads the state announced by the task's getState() operation
-        def read_toplevel_state
-            value = CORBA.refine_exceptions(self) { do_state }
+        #
+        # @param [Numeric,nil] timeout the call timeout in seconds, see
+        #   {CORBA.with_call_timeout}
+        # @return [Symbol]
+        def read_toplevel_state(timeout: nil)
+            value = CORBA.with_call_timeout(timeout) do
+                CORBA.refine_exceptions(self) { do_state }
+            end
             @state_symbols[value]
         end
 
+        # Reads the task's state in the background
+        #
+        # @return [AsyncCall] a call whose value is the state symbol, as
+        #   returned by {#read_toplevel_state}
+        def read_toplevel_state_async
+            do_state_async.setup(self) { |value| @state_symbols[value] }
+        end
+
         def rtt_state
             warn "TaskContext#rtt_state is deprecated, use read_toplevel_state instead"
             read_toplevel_state
@@ -133,8 +190,27 @@ def to_s
         # configuration manager to the TaskContext
         #
         # See also #load_conf and #Runkit.load_config_dir
-        def apply_conf(section_names = [], override = false)
-            Runkit.conf.apply(self, section_names, override)
+        def apply_conf(section_names = [], override = false, diff: false)
+            Runkit.conf.apply(self, section_names, override: override, diff: diff)
+        end
+
+        # The last known values of this task's properties
+        #
+        # It is filled and used by {TaskConfigurations#apply} in diff mode, to
+        # avoid writing properties whose value did not change. Writing a
+        # property through {Property#write} removes it from the cache.
+        # Changes made by other means (e.g. by another process, or by the task
+        # itself) are not tracked, call {#clear_property_cache} when they may
+        # happen.
+        #
+        # @return [Hash<String,Typelib::Type>]
+        def property_cache
+            @property_cache ||= {}
+        end
+
+        # Empties {#property_cache}
+        def clear_property_cache
+            @property_cache&.clear
         end
 
         # Saves the current configuration into a file
@@ -317,6 +393,95 @@ def property(name)
             Property.new(self, name, property_model)
         end
 
+        # Reads many properties at once
+        #
+        # The calls are made in parallel, with the GVL released only once. An
+        # error while reading one property does not prevent reading the
+        # others.
+        #
+        # @param [Array<String>] names
+        # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+        #   {CORBA.with_call_timeout}
+        # @return [Hash<String,Typelib::Type|Exception>] for each property,
+        #   either its value or the error raised while reading it
+        def raw_read_properties(names, timeout: nil)
+            names = names.map(&:to_s)
+            properties = names.map { |n| property(n) }
+            results = CORBA.with_call_timeout(timeout) do
+                CORBA.refine_exceptions(self) do
+                    do_properties_read(
+                        names, properties.map(&:runkit_type_name),
+                        properties.map { |p| p.type.new }
+                    )
+                end
+            end
+            names.zip(results).each_with_object({}) do |(name, result), h|
+                h[name] = property_error(result, "read", name)
+            end
+        end
+
+        # Writes many properties at once
+        #
+        # All the values are converted and marshalled first, and the calls are
+        # then made in parallel with the GVL released only once. Dynamic
+        # properties are written one by one through their update operation,
+        # unless direct is true.
+        #
+        # @param [Hash<String,Object>] values the properties' new values
+        # @param [Boolean] direct (see Property#write)
+        # @param [Numeric,nil] timeout the timeout of each call in seconds, see
+        #   {CORBA.with_call_timeout}
+        # @return [Hash<String,Boolean|Exception>] for each property, whether
+        #   the task accepted the new value, or the error raised while writing
+        #   it
+        def write_properties(values, direct: false, timeout: nil)
+            entries = values.map do |name, value|
+                p = property(name.to_s)
+                [name.to_s, p, Typelib.from_ruby(value, p.type)]
+            end
+            dynamic, static = entries.partition { |_, p, _| !direct && p.dynamic? }
+
+            results = {}
+            CORBA.with_call_timeout(timeout) do
+                dynamic.each do |name, p, value|
+                    results[name] =
+                        begin
+                            p.write(value)
+                            true
+                        rescue StandardError => e
+                            property_error(e, "write", name)
+                        end
+                end
+
+                bulk = CORBA.refine_exceptions(self) do
+                    do_properties_write(
+                        static.map(&:first), static.map { |_, p, _| p.runkit_type_name },
+                        static.map(&:last)
+                    )
+                end
+                static.zip(bulk) do |(name, _), result|
+                    results[name] = property_error(result, "write", name)
+                end
+            end
+            results
+        end
+
+        # @api private
+        #
+        # Adds the property and task names to the message of an error returned
+        # by the bulk property accessors
+        #
+        # @return [Object] the error with the new message, or result if it is
+        #   not an error
+        def property_error(result, action, name)
+            return result unless result.kind_of?(Exception)
+
+            result.exception(
+                "failed to #{action} property #{name} on task #{self.name}: " \
+                "#{result.message}"
+            )
+        end
+
         # @api private
         #
         # Resolve a Port object for the given port name
@@ -370,15 +535,72 @@ def port_names
             end
         end
 
+        # Builds a model of the whole task interface in a single call
+        #
+        # Discovering the interface object by object (e.g. with {#port},
+        # {#property} or {#each_port}) costs one or two remote calls per
+        # object. This instead fetches all ports, properties, attributes and
+        # operation names at once, with the calls made in parallel on the C++
+        # side.
+        #
+        # Assign the result to {#model} to avoid any further interface
+        # discovery:
+        #
+        #   task.model = task.introspect
+        #
+        # @return [OroGen::Spec::TaskContext]
+        def introspect
+            snapshot = CORBA.refine_exceptions(self) { do_introspect }
+            self.class.model_from_introspection(
+                name, snapshot, loader: model.loader
+            )
+        end
+
+        # @api private
+        #
+        # Create a model from the information returned by {#do_introspect}
+        def self.model_from_introspection(name, snapshot, loader:)
+            resolve = ->(type) { loader.resolve_type(type, define_dummy_type: true) }
+
+            model = empty_orogen_model(name, loader: loader)
+            snapshot[:ports].each do |port_name, is_output, type_name|
+                next if model.find_port(port_name)
+
+                if is_output
+                    model.output_port port_name, resolve.call(type_name)
+                else
+                    model.input_port port_name, resolve.call(type_name)
+                end
+            end
+            snapshot[:properties].each do |property_name, type_name|
+                next if model.find_property(property_name)
+
+                model.property property_name, resolve.call(type_name)
+            end
+            snapshot[:attributes].each do |attribute_name, type_name|
+                next if model.find_attribute(attribute_name)
+
+                model.attribute attribute_name, resolve.call(type_name)
+            end
+            snapshot[:operations].each do |operation_name|
+                next if model.find_operation(operation_name)
+
+                model.operation operation_name
+            end
+            model
+        end
+
         # Returns an Operation object that represents the given method on the
         # remote component.
         #
+        # The operation's signature is read from the remote component only
+        # once per TaskContext object.
+        #
         # Raises NotFound if no such operation exists.
         def operation(name)
             name = name.to_s
             CORBA.refine_exceptions(self) do
-                return_types = operation_return_types(name)
-                arguments = operation_argument_types(name)
+                return_types, arguments = operation_signature(name)
                 Operation.new(self, name, return_types, arguments)
             end
         rescue Runkit::NotFound => e
@@ -390,8 +612,8 @@ def operation(name)
         # Calls the required operation with the given argument
         #
         # This is a shortcut for operation(name).calldop(*arguments)
-        def callop(name, *args)
-            operation(name).callop(*args)
+        def callop(name, *args, timeout: nil)
+            operation(name).callop(*args, timeout: timeout)
         end
 
         # Sends the required operation with the given argument
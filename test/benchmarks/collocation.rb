@@ -0,0 +1,56 @@
+# frozen_string_literal: true
+
+# Compares calls on a Ruby task of the same process made through CORBA against
+# the same calls made directly on the task (see Runkit::CORBA.collocation=)
+#
+# Usage: ruby collocation.rb [REPEAT]
+
+require "runkit"
+
+Runkit.initialize
+Runkit.load_typekit "std"
+repeat = Integer(ARGV[0] || 10_000)
+
+def measure(repeat)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    repeat.times { yield }
+    (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) / repeat
+end
+
+task = Runkit::RubyTasks::TaskContext.new(
+    "collocation", register_on_name_server: false
+)
+task.create_property "prop", "/int32_t"
+task.create_output_port "out", "/int32_t"
+consumer = Runkit::RubyTasks::TaskContext.new(
+    "collocation_consumer", register_on_name_server: false
+)
+consumer.create_input_port "in", "/int32_t"
+
+results = [true, false].map do |collocation|
+    Runkit::CORBA.collocation = collocation
+    proxy = Runkit::TaskContext.new(task.ior, name: task.name)
+    in_p = Runkit::TaskContext.new(consumer.ior, name: consumer.name).port("in")
+    property = proxy.property("prop")
+    out_p = proxy.port("out")
+
+    state = measure(repeat) { proxy.read_toplevel_state }
+    read = measure(repeat) { property.raw_read }
+    write = measure(repeat) { property.write(42) }
+    connect = measure(repeat / 10) do
+        out_p.connect_to in_p
+        out_p.disconnect_from in_p
+    end
+    [collocation, state, read, write, connect]
+end
+Runkit::CORBA.collocation = false
+
+results.each do |collocation, state, read, write, connect|
+    puts format("%<mode>-8s state %<state>.1fus, property read %<read>.1fus, " \
+                "property write %<write>.1fus, connect+disconnect %<connect>.1fus",
+                mode: collocation ? "direct" : "CORBA",
+                state: state * 1e6, read: read * 1e6, write: write * 1e6,
+                connect: connect * 1e6)
+end
+task.dispose
+consumer.dispose
@@ -0,0 +1,81 @@
+# frozen_string_literal: true
+
+# Compares the time needed to discover the tasks registered on a CORBA name
+# service by resolving them one by one against a single resolve_all call, as a
+# function of the number of registered tasks
+#
+# Usage: ruby name_service_resolve_all.rb [TASK_COUNTS]
+#
+# TASK_COUNTS is a comma-separated list of task counts (10,100,400 by
+# default). The benchmark starts its own omniNames, which must be in PATH.
+# Set RUNKIT_EMBEDDED_NAME_SERVICE=1 to use the name service served by this
+# process instead (see Runkit::CORBA.start_name_service)
+
+require "runkit"
+require "socket"
+require "tmpdir"
+
+Runkit.initialize
+task_counts = (ARGV[0] || "10,100,400").split(",").map { |s| Integer(s) }
+repeat = 5
+
+def measure(repeat)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    repeat.times { yield }
+    (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) / repeat
+end
+
+if ENV["RUNKIT_EMBEDDED_NAME_SERVICE"] == "1"
+    address = Runkit::CORBA.start_name_service
+else
+    tcp = TCPServer.new(0)
+    port = tcp.addr[1]
+    tcp.close
+    datadir = Dir.mktmpdir
+    pid = spawn("omniNames", "-always", "-start", port.to_s, "-datadir", datadir,
+                out: "/dev/null", err: "/dev/null")
+    address = "localhost:#{port}"
+end
+
+begin
+    name_service = Runkit::NameServices::CORBA.new(address)
+    deadline = Time.now + 5
+    begin
+        name_service.names
+    rescue Runkit::ComError
+        raise if Time.now > deadline
+
+        sleep 0.1
+        retry
+    end
+
+    tasks = []
+    task_counts.each do |count|
+        while tasks.size < count
+            task = Runkit::RubyTasks::TaskContext.new(
+                "resolve_all_#{tasks.size}", register_on_name_server: false
+            )
+            name_service.register(task)
+            tasks << task
+        end
+
+        serial = measure(repeat) do
+            name_service.names.each { |n| name_service.ior(n) }
+        end
+        resolve_all = measure(repeat) do
+            name_service.resolve_all
+        end
+
+        puts format("%<count>4d tasks: names+ior %<serial>.2fms, " \
+                    "resolve_all %<resolve_all>.2fms",
+                    count: count, serial: serial * 1000,
+                    resolve_all: resolve_all * 1000)
+    end
+    tasks.each(&:dispose)
+ensure
+    if pid
+        Process.kill "INT", pid
+        Process.waitpid pid
+        FileUtils.rm_rf datadir
+    end
+end
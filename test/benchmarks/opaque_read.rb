@@ -0,0 +1,54 @@
+# frozen_string_literal: true
+
+# Measures the cost of reading large samples of a type that contains opaques
+# on a local input port, and how many times each sample gets copied after its
+# conversion from the orocos sample
+#
+# Usage: ruby opaque_read.rb [POINT_COUNT] [SAMPLE_COUNT]
+
+require "runkit"
+
+Runkit.initialize
+Runkit.load_typekit "base"
+point_count = Integer(ARGV[0] || 1_000_000)
+count = Integer(ARGV[1] || 50)
+
+points_t = Runkit.default_loader.resolve_type "/std/vector</base/Vector3d>"
+producer = Runkit::RubyTasks::TaskContext.new(
+    "opaque_read_producer", register_on_name_server: false
+)
+consumer = Runkit::RubyTasks::TaskContext.new(
+    "opaque_read_consumer", register_on_name_server: false
+)
+out_p = producer.create_output_port("out", points_t)
+in_p = consumer.create_input_port("in", points_t)
+out_p.connect_to in_p
+
+sample = out_p.new_sample
+point = sample.class.deference.new
+point.data.to_a.each_index { |i| point.data[i] = i }
+point_count.times { sample << point }
+sample_size = point_count * point.class.size
+
+out_p.write(sample)
+buffer = in_p.raw_read(in_p.new_sample)
+Runkit.reset_handle_pool_stats
+
+elapsed = 0
+count.times do
+    out_p.write(sample)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    in_p.raw_read_new(buffer)
+    elapsed += Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+end
+
+stats = Runkit.handle_pool_stats.fetch(points_t.name)
+copies = Float(stats[:copies]) / count
+puts format("%<size>.1f MB per sample, %<time>.2f ms per read",
+            size: sample_size / 1e6, time: elapsed / count * 1000)
+puts format("%<copies>.2f copies after conversion per sample, " \
+            "%<bytes>d bytes copied per sample",
+            copies: copies, bytes: (copies * sample_size).round)
+
+producer.dispose
+consumer.dispose
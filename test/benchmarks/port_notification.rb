@@ -0,0 +1,63 @@
+# frozen_string_literal: true
+
+# Compares the wake-up latency of a reader that polls a local input port
+# against one that waits on the port's notification IO
+#
+# Usage: ruby port_notification.rb [SAMPLE_COUNT] [POLL_PERIOD_MS]
+
+require "runkit"
+
+Runkit.initialize
+count = Integer(ARGV[0] || 200)
+poll_period = Float(ARGV[1] || 1) / 1000
+
+double_t = Runkit.default_loader.resolve_type "/double"
+producer = Runkit::RubyTasks::TaskContext.new(
+    "port_notification_producer", register_on_name_server: false
+)
+consumer = Runkit::RubyTasks::TaskContext.new(
+    "port_notification_consumer", register_on_name_server: false
+)
+out_p = producer.create_output_port("out", double_t)
+in_p = consumer.create_input_port("in", double_t)
+out_p.connect_to in_p, type: :buffer, size: 100
+
+def measure(count, out_p, in_p)
+    latencies = []
+    writer = Thread.new do
+        count.times do
+            sleep(0.002 + rand * 0.002)
+            out_p.write(Process.clock_gettime(Process::CLOCK_MONOTONIC))
+        end
+    end
+
+    while latencies.size < count
+        yield
+        while (sent = in_p.read_new)
+            latencies << Process.clock_gettime(Process::CLOCK_MONOTONIC) - sent
+        end
+    end
+    writer.join
+    latencies.sort
+end
+
+def report(name, latencies)
+    avg = latencies.sum / latencies.size
+    median = latencies[latencies.size / 2]
+    p99 = latencies[(latencies.size * 0.99).floor]
+    format("%-30s avg=%.3fms median=%.3fms p99=%.3fms",
+           name, avg * 1000, median * 1000, p99 * 1000)
+end
+
+polling = measure(count, out_p, in_p) { sleep(poll_period) }
+puts report("polling (#{poll_period * 1000}ms)", polling)
+
+io = in_p.notification_io
+notified = measure(count, out_p, in_p) do
+    IO.select([io])
+    in_p.clear_notification
+end
+puts report("notification IO", notified)
+
+producer.dispose
+consumer.dispose
@@ -0,0 +1,47 @@
+# frozen_string_literal: true
+
+# Compares the time needed to read the state of many tasks one by one against a
+# single Runkit.states_of call, as a function of the number of tasks
+#
+# Usage: ruby states_of.rb [TASK_COUNTS]
+#
+# TASK_COUNTS is a comma-separated list of task counts (10,100,300 by default).
+# To measure the effect of network latency, run the tasks on another host or
+# add latency to the loopback interface with `tc qdisc add dev lo root netem
+# delay 1ms`
+
+require "runkit"
+
+Runkit.initialize
+task_counts = (ARGV[0] || "10,100,300").split(",").map { |s| Integer(s) }
+repeat = 10
+
+def measure(repeat)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    repeat.times { yield }
+    (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) / repeat
+end
+
+local_tasks = []
+task_counts.each do |count|
+    while local_tasks.size < count
+        local_tasks << Runkit::RubyTasks::TaskContext.new(
+            "states_of_#{local_tasks.size}", register_on_name_server: false
+        )
+    end
+    tasks = local_tasks.first(count).map do |t|
+        Runkit::TaskContext.new(t.ior, name: t.name)
+    end
+
+    serial = measure(repeat) do
+        tasks.each(&:read_toplevel_state)
+    end
+    fan_out = measure(repeat) do
+        Runkit.states_of(tasks)
+    end
+
+    puts format("%<count>4d tasks: serial %<serial>.2fms, " \
+                "states_of %<fan_out>.2fms",
+                count: count, serial: serial * 1000, fan_out: fan_out * 1000)
+end
+local_tasks.each(&:dispose)
@@ -0,0 +1,57 @@
+# frozen_string_literal: true
+
+# Compares the time needed to discover the whole interface of a task by
+# querying it object by object against a single TaskContext#introspect call,
+# as a function of the number of ports
+#
+# Usage: ruby task_introspection.rb [PORT_COUNTS]
+#
+# PORT_COUNTS is a comma-separated list of port counts (10,20,40 by default).
+# To measure the effect of network latency, run the tasks on another host or
+# add latency to the loopback interface with `tc qdisc add dev lo root netem
+# delay 1ms`
+
+require "runkit"
+
+Runkit.initialize
+port_counts = (ARGV[0] || "10,20,40").split(",").map { |s| Integer(s) }
+repeat = 10
+
+double_t = Runkit.default_loader.resolve_type "/double"
+
+def measure(repeat)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    repeat.times { yield }
+    (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) / repeat
+end
+
+port_counts.each do |count|
+    local = Runkit::RubyTasks::TaskContext.new(
+        "task_introspection_#{count}", register_on_name_server: false
+    )
+    (count / 2).times do |i|
+        local.create_input_port("in#{i}", double_t)
+        local.create_output_port("out#{i}", double_t)
+    end
+    4.times { |i| local.create_property("p#{i}", double_t) }
+
+    per_object = measure(repeat) do
+        task = Runkit::TaskContext.new(local.ior, name: local.name)
+        task.each_port.to_a
+        task.property_names.each { |name| task.property(name) }
+        task.attribute_names.each { |name| task.attribute(name) }
+    end
+    introspect = measure(repeat) do
+        task = Runkit::TaskContext.new(local.ior, name: local.name)
+        task.model = task.introspect
+        task.each_port.to_a
+        task.property_names.each { |name| task.property(name) }
+        task.attribute_names.each { |name| task.attribute(name) }
+    end
+
+    puts format("%<count>4d ports: per-object %<per_object>.2fms, " \
+                "introspect %<introspect>.2fms",
+                count: count, per_object: per_object * 1000,
+                introspect: introspect * 1000)
+    local.dispose
+end
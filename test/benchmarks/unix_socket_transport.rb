@@ -0,0 +1,77 @@
+# frozen_string_literal: true
+
+# Compares the call latency and port throughput between two processes of the
+# same machine when they talk over TCP loopback and over a unix socket (see
+# the unix: option of Runkit::CORBA.initialize)
+#
+# Usage: ruby unix_socket_transport.rb [REPEAT] [SAMPLE_SIZE]
+#
+# SAMPLE_SIZE is the size in bytes of the samples written on the port (64k by
+# default). Since the ORB can be initialized only once per process, the
+# benchmark runs each measurement in a pair of new processes
+
+require "runkit"
+
+def initialize_runkit(transport)
+    Runkit.initialize(unix: transport == "unix")
+    Runkit.load_typekit "std"
+end
+
+def measure(repeat)
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+    repeat.times { yield }
+    (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) / repeat
+end
+
+# Creates the task the client talks to, and prints its IOR
+def server(transport)
+    initialize_runkit(transport)
+    task = Runkit::RubyTasks::TaskContext.new(
+        "unix_socket_transport", register_on_name_server: false
+    )
+    task.create_input_port "in", "/std/string"
+    $stdout.puts task.ior
+    $stdout.flush
+    $stdin.read
+    task.dispose
+end
+
+def client(transport, ior, repeat, sample_size)
+    initialize_runkit(transport)
+    task = Runkit::TaskContext.new(ior, name: "unix_socket_transport")
+    latency = measure(repeat) { task.read_toplevel_state }
+
+    local = Runkit::RubyTasks::TaskContext.new(
+        "unix_socket_transport_client", register_on_name_server: false
+    )
+    out_p = local.create_output_port "out", "/std/string"
+    out_p.connect_to task.port("in"), type: :buffer, size: 10
+    sample = "x" * sample_size
+    write = measure(repeat / 10) { out_p.write(sample) }
+    task.read_toplevel_state
+    local.dispose
+
+    puts format("%<transport>-5s call latency %<latency>.3fms, " \
+                "%<size>dB sample writes %<rate>.1f MB/s",
+                transport: transport, latency: latency * 1000,
+                size: sample_size, rate: sample_size / write / 1e6)
+end
+
+case ARGV[0]
+when "--server"
+    server(ARGV[1])
+when "--client"
+    client(ARGV[1], ARGV[2], Integer(ARGV[3]), Integer(ARGV[4]))
+else
+    repeat = Integer(ARGV[0] || 10_000)
+    sample_size = Integer(ARGV[1] || 65_536)
+    %w[tcp unix].each do |transport|
+        IO.popen([RbConfig.ruby, __FILE__, "--server", transport], "r+") do |io|
+            ior = io.gets.chomp
+            pid = spawn(RbConfig.ruby, __FILE__, "--client", transport, ior,
+                        repeat.to_s, sample_size.to_s)
+            Process.waitpid pid
+            io.close_write
+        end
+    end
+end
@@ -33,6 +33,68 @@ module NameServices
                 assert_equal [], name_service.names
             end
 
+            describe "#resolve_all" do
+                it "returns the name and IOR of all registered task contexts" do
+                    tasks = Array.new(3) { |i| new_ruby_task_context "test_#{i}" }
+                    tasks.each { |t| name_service.register t }
+                    expected = tasks.to_h { |t| [t.name, t.ior] }
+                    assert_equal expected, name_service.resolve_all(chunk_size: 2)
+                end
+
+                it "returns an empty hash if there are no task contexts" do
+                    assert_equal({}, name_service.resolve_all)
+                end
+
+                it "raises ArgumentError if chunk_size is lower than 1" do
+                    assert_raises(ArgumentError) do
+                        name_service.resolve_all(chunk_size: 0)
+                    end
+                end
+
+                it "raises ArgumentError if max_threads is lower than 1" do
+                    assert_raises(ArgumentError) do
+                        name_service.resolve_all(max_threads: 0)
+                    end
+                end
+            end
+
+            describe "#watch" do
+                before do
+                    @watcher = name_service.watch(period: 0.01)
+                end
+
+                after do
+                    @watcher.stop
+                end
+
+                it "reports the names that appear and disappear" do
+                    task = new_ruby_task_context "test"
+                    name_service.register task
+                    assert_equal [CORBA::Watcher::Change.new(:added, "test")],
+                                 @watcher.pop(timeout: 5)
+
+                    name_service.deregister "test"
+                    assert_equal [CORBA::Watcher::Change.new(:removed, "test")],
+                                 @watcher.pop(timeout: 5)
+                end
+
+                it "reports the names registered before it started as added" do
+                    @watcher.stop
+                    name_service.register new_ruby_task_context("test")
+                    @watcher = name_service.watch(period: 0.01)
+                    assert_equal [CORBA::Watcher::Change.new(:added, "test")],
+                                 @watcher.pop(timeout: 5)
+                end
+
+                it "reports the cost of the polling" do
+                    sleep 0.1
+                    stats = @watcher.stats
+                    assert_operator stats.polls, :>, 1
+                    assert_equal 0, stats.errors
+                    assert_operator stats.total_duration, :>, 0
+                end
+            end
+
             describe "#get" do
                 it "resolves an existing task" do
                     task = new_ruby_task_context "test"
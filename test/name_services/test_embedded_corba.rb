@@ -0,0 +1,52 @@
+# frozen_string_literal: true
+
+require "runkit/test"
+
+module Runkit
+    module NameServices
+        describe "the in-process CORBA name service" do
+            attr_reader :name_service
+
+            before do
+                @name_service = CORBA.new(Runkit::CORBA.start_name_service)
+            end
+
+            after do
+                Runkit::CORBA.stop_name_service
+            end
+
+            it "returns an empty list if there are no task contexts" do
+                assert_equal [], name_service.names
+            end
+
+            it "registers and resolves task contexts" do
+                task = new_ruby_task_context "test"
+                name_service.register task
+                assert_equal ["test"], name_service.names
+                assert_equal task.ior, name_service.ior("test")
+                assert_equal task, name_service.get("test")
+            end
+
+            it "deregisters task contexts" do
+                name_service.register new_ruby_task_context("test")
+                name_service.deregister "test"
+                assert_equal [], name_service.names
+                assert_raises(NotFound) { name_service.ior("test") }
+            end
+
+            it "lists the bindings in chunks" do
+                tasks = Array.new(5) { |i| new_ruby_task_context "test_#{i}" }
+                tasks.each { |t| name_service.register t }
+                expected = tasks.to_h { |t| [t.name, t.ior] }
+                assert_equal expected, name_service.resolve_all(chunk_size: 2)
+            end
+
+            it "loses its bindings when stopped" do
+                name_service.register new_ruby_task_context("test")
+                Runkit::CORBA.stop_name_service
+                name_service = CORBA.new(Runkit::CORBA.start_name_service)
+                assert_equal [], name_service.names
+            end
+        end
+    end
+end
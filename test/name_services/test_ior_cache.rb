@@ -0,0 +1,104 @@
+# frozen_string_literal: true
+
+require "runkit/test"
+
+module Runkit
+    module NameServices
+        describe IORCache do
+            before do
+                @path = File.join(make_tmpdir, "ior_cache")
+                @backend = Local.new
+                @cache = IORCache.new(@backend, path: @path)
+            end
+
+            it "resolves a task through the backend and caches its IOR on disk" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                assert_equal task, @cache.get("test")
+
+                @backend.deregister "test"
+                cache = IORCache.new(@backend, path: @path)
+                assert_equal task.ior, cache.ior("test")
+                assert_equal task, cache.get("test")
+            end
+
+            it "resolves the task again if the cached IOR is not valid anymore" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                @cache.get("test")
+                task.dispose
+
+                new_task = new_ruby_task_context "test"
+                @backend.register new_task
+                cache = IORCache.new(@backend, path: @path)
+                assert_equal new_task.ior, cache.ior("test")
+            end
+
+            it "resolves the task again if the cached IOR fails on get" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                @cache.get("test")
+                task.dispose
+
+                new_task = new_ruby_task_context "test"
+                @backend.register new_task
+                cache = IORCache.new(@backend, path: @path)
+                assert_equal new_task, cache.get("test")
+            end
+
+            it "raises NotFound if the backend does not know a name" do
+                assert_raises(NotFound) { @cache.get("does_not_exist") }
+            end
+
+            it "caches the task interface if introspect is set" do
+                task = new_ruby_task_context "test"
+                task.create_output_port "out", "/double"
+                @backend.register task
+                IORCache.new(@backend, path: @path, introspect: true).get("test")
+
+                cache = IORCache.new(@backend, path: @path, introspect: true)
+                remote = cache.get("test")
+                assert remote.model.find_output_port("out")
+            end
+
+            it "keeps the entries of different scopes apart" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                @cache.get("test")
+
+                other = IORCache.new(Local.new, path: @path, scope: "other")
+                assert_raises(NotFound) { other.ior("test") }
+            end
+
+            it "stores the cache as JSON" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                @cache.get("test")
+
+                data = JSON.parse(File.read(@path))
+                assert_equal task.ior, data[@cache.scope]["test"]["ior"]
+            end
+
+            it "ignores a cache file it cannot parse" do
+                File.write(@path, Marshal.dump({}))
+                task = new_ruby_task_context "test"
+                @backend.register task
+                assert_equal task, @cache.get("test")
+            end
+
+            it "merges the entries saved by other caches on the same file" do
+                task = new_ruby_task_context "test"
+                @backend.register task
+                other_backend = Local.new
+                other_backend.register task, name: "other_test"
+                other = IORCache.new(other_backend, path: @path, scope: "other")
+
+                @cache.get("test")
+                other.get("other_test")
+                cache = IORCache.new(@backend, path: @path)
+                @backend.deregister "test"
+                assert_equal task.ior, cache.ior("test")
+            end
+        end
+    end
+end
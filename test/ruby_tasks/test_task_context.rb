@@ -105,6 +105,213 @@ module RubyTasks
                         assert_equal 10, in_p.read
                     end
 
+                    it "reads successive samples into the sample given by the caller" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+
+                        out_p.connect_to in_p, type: :buffer, size: 10
+                        out_p.write 10
+                        out_p.write 20
+                        first = in_p.raw_read_new(in_p.new_sample)
+                        second = in_p.raw_read_new(in_p.new_sample)
+                        assert_equal 10, Typelib.to_ruby(first)
+                        assert_equal 20, Typelib.to_ruby(second)
+                    end
+
+                    it "drains all queued samples in one call" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+
+                        out_p.connect_to in_p, type: :buffer, size: 10
+                        5.times { |i| out_p.write i }
+                        buffer = in_p.new_drain_buffer(3)
+                        assert_equal 3, in_p.drain(buffer)
+                        assert_equal [0, 1, 2], buffer.to_a
+                        assert_equal [3, 4], in_p.read_all
+                        assert_equal [], in_p.read_all
+                    end
+
+                    it "drains the samples of a pull connection" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+
+                        out_p.connect_to in_p, type: :buffer, size: 10, pull: true
+                        assert in_p.blocking_read?
+                        5.times { |i| out_p.write i }
+                        buffer = in_p.new_drain_buffer(3)
+                        assert_equal 3, in_p.drain(buffer)
+                        assert_equal [0, 1, 2], buffer.to_a
+                        assert_equal [3, 4], in_p.read_all
+                    end
+
+                    it "writes many samples in one call" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+
+                        out_p.connect_to in_p, type: :buffer, size: 3
+                        assert_equal 3, out_p.write_many([0, 1, 2, 3, 4])
+                        assert_equal [0, 1, 2], in_p.read_all
+                    end
+
+                    it "returns zero when writing an empty collection" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        assert_equal 0, out_p.write_many([])
+                    end
+
+                    it "reuses its marshalling buffer between writes" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+                        out_p.connect_to in_p, type: :buffer, size: 10
+
+                        out_p.write_many([0, 1, 2])
+                        registered = @int32_t.registry.each.to_a.size
+                        out_p.write_many([3, 4])
+                        out_p.write_many([5, 6, 7, 8])
+                        assert_equal registered, @int32_t.registry.each.to_a.size
+                        assert_equal (0..8).to_a, in_p.read_all
+                    end
+
+                    it "signals new data through the notification IO" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+                        out_p.connect_to in_p, type: :buffer, size: 10
+
+                        io = in_p.notification_io
+                        refute IO.select([io], nil, nil, 0)
+                        out_p.write 10
+                        assert IO.select([io], nil, nil, 1)
+                        in_p.clear_notification
+                        refute IO.select([io], nil, nil, 0)
+                        assert_equal 10, in_p.read_new
+                    end
+
+                    it "stops notifying once the notification is disabled" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in_p = consumer.create_input_port("p", @int32_t)
+                        out_p.connect_to in_p, type: :buffer, size: 10
+
+                        io = in_p.notification_io
+                        in_p.disable_notification
+                        refute in_p.notification_enabled?
+                        assert io.closed?
+
+                        out_p.write 10
+                        refute IO.select([in_p.notification_io], nil, nil, 0.1)
+                    end
+
+                    it "closes the notification IO when the port is removed" do
+                        task = new_ruby_task_context("task")
+                        in_p = task.create_input_port("p", @int32_t)
+                        io = in_p.notification_io
+                        in_p.remove
+                        assert io.closed?
+                    end
+
+                    it "waits for data on any of a set of ports" do
+                        producer = new_ruby_task_context("producer")
+                        out_p = producer.create_output_port("p", @int32_t)
+                        consumer = new_ruby_task_context("consumer")
+                        in1 = consumer.create_input_port("in1", @int32_t)
+                        in2 = consumer.create_input_port("in2", @int32_t)
+                        out_p.connect_to in2, type: :buffer, size: 10
+
+                        assert_equal [], Runkit.wait_any([in1, in2], timeout: 0.01)
+                        out_p.write 10
+                        assert_equal [in2], Runkit.wait_any([in1, in2], timeout: 1)
+                        assert_equal 10, in2.read_new
+                        assert_equal [], Runkit.wait_any([in1, in2], timeout: 0)
+                    end
+
+                    it "reuses the marshalling handles of opaque types" do
+                        task = new_ruby_task_context("task")
+                        out_p = task.create_output_port("out", @spline_t)
+                        in_p = task.create_input_port("in", @spline_t)
+                        out_p.connect_to in_p, type: :buffer, size: 10
+
+                        sample = out_p.new_sample
+                        sample.geometric_resolution = 0.1
+                        sample.curve_order = 3
+                        sample.dimension = 3
+                        out_p.write(sample)
+                        assert in_p.raw_read_new
+
+                        Runkit.reset_handle_pool_stats
+                        5.times do
+                            out_p.write(sample)
+                            assert in_p.raw_read_new
+                        end
+                        stats = Runkit.handle_pool_stats.fetch(@spline_t.name)
+                        assert_equal 0, stats[:misses]
+                        assert_equal 10, stats[:hits]
+                    end
+
+                    it "converts opaque samples in place when reading" do
+                        task = new_ruby_task_context("task")
+                        out_p = task.create_output_port("out", @spline_t)
+                        in_p = task.create_input_port("in", @spline_t)
+                        out_p.connect_to in_p, type: :buffer, size: 10
+
+                        sample = out_p.new_sample
+                        sample.geometric_resolution = 0.1
+                        sample.curve_order = 3
+                        sample.dimension = 3
+                        Runkit.reset_handle_pool_stats
+                        out_p.write(sample)
+                        assert_equal sample, in_p.raw_read_new
+                        stats = Runkit.handle_pool_stats.fetch(@spline_t.name)
+                        assert_equal 0, stats[:copies]
+                    end
+
+                    it "exposes the buffer of array samples without copying it" do
+                        vector_t = @loader.resolve_type "/std/vector</double>"
+                        task = new_ruby_task_context("task")
+                        out_p = task.create_output_port("out", vector_t)
+                        in_p = task.create_input_port("in", vector_t)
+                        out_p.connect_to in_p
+
+                        out_p.write [1, 2, 3]
+                        sample = in_p.raw_read
+                        buffer = Runkit.sample_buffer(sample)
+                        assert buffer.frozen?
+                        assert_equal [1, 2, 3], buffer.unpack("d*")
+                        sample[1] = 42
+                        assert_equal [1, 42, 3], buffer.unpack("d*")
+                    end
+
+                    it "exports the buffer of array samples through MemoryView" do
+                        skip "MemoryView is not available" unless Runkit.memory_view_enabled?
+
+                        require "fiddle"
+                        vector_t = @loader.resolve_type "/std/vector</double>"
+                        task = new_ruby_task_context("task")
+                        out_p = task.create_output_port("out", vector_t)
+                        in_p = task.create_input_port("in", vector_t)
+                        out_p.connect_to in_p
+
+                        out_p.write [1, 2, 3]
+                        sample = in_p.raw_read
+                        Fiddle::MemoryView.export(sample) do |view|
+                            assert_equal "d", view.format
+                            assert_equal 8, view.item_size
+                            assert_equal [1, 2, 3], view.to_s.unpack("d*")
+                        end
+                    end
+
                     it "gets an exception if the typelib value cannot be converted to the intermediate opaque type" do
                         task = new_ruby_task_context "task"
                         port = task.create_output_port "out", @spline_t
@@ -250,6 +457,86 @@ module RubyTasks
                 end
             end
 
+            describe "collocation" do
+                after do
+                    Runkit::CORBA.collocation = false
+                end
+
+                [true, false].each do |collocation|
+                    describe "with collocation=#{collocation}" do
+                        before do
+                            Runkit::CORBA.collocation = collocation
+                            @task = new_ruby_task_context("task")
+                            @proxy = Runkit::TaskContext.new(@task.ior, name: @task.name)
+                        end
+
+                        it "reads the task state" do
+                            @task.configure
+                            assert_direct_calls(collocation) do
+                                assert_equal :STOPPED, @proxy.read_toplevel_state
+                            end
+                        end
+
+                        it "reads and writes properties" do
+                            @task.create_property("prop", @int32_t)
+                            prop = @proxy.property("prop")
+                            assert_direct_calls(collocation) do
+                                prop.write(10)
+                                assert_equal 10, prop.read
+                            end
+                            assert_equal 10, @task.property("prop").read
+                        end
+
+                        it "connects and disconnects ports" do
+                            out_p = @task.create_output_port("out", @int32_t)
+                            consumer = new_ruby_task_context("consumer")
+                            in_p = consumer.create_input_port("in", @int32_t)
+
+                            proxy_out = @proxy.port("out")
+                            assert_direct_calls(collocation) do
+                                proxy_out.connect_to in_p
+                            end
+                            assert proxy_out.connected?
+                            out_p.write 10
+                            assert_equal 10, in_p.read
+                            assert proxy_out.disconnect_from(in_p)
+                            refute in_p.connected?
+                        end
+                    end
+                end
+
+                # Asserts that the block calls a collocated task directly if
+                # collocation is true, and only goes through CORBA otherwise
+                def assert_direct_calls(collocation)
+                    count = Runkit::CORBA.collocated_call_count
+                    yield
+                    if collocation
+                        assert_operator Runkit::CORBA.collocated_call_count, :>, count
+                    else
+                        assert_equal count, Runkit::CORBA.collocated_call_count
+                    end
+                end
+
+                it "does not reuse a proxy created with another setting" do
+                    Runkit::CORBA.collocation = true
+                    task = new_ruby_task_context("task")
+                    Runkit::CORBA.collocation = false
+                    proxy = Runkit::TaskContext.new(task.ior, name: task.name)
+                    assert_direct_calls(false) { proxy.read_toplevel_state }
+                    Runkit::CORBA.collocation = true
+                    proxy = Runkit::TaskContext.new(task.ior, name: task.name)
+                    assert_direct_calls(true) { proxy.read_toplevel_state }
+                end
+
+                it "falls back to CORBA once the task is disposed of" do
+                    Runkit::CORBA.collocation = true
+                    task = new_ruby_task_context("task")
+                    proxy = Runkit::TaskContext.new(task.ior, name: task.name)
+                    task.dispose
+                    assert_raises(Runkit::ComError) { proxy.read_toplevel_state }
+                end
+            end
+
             it "handles the normal state changes" do
                 task = new_ruby_task_context("task")
                 assert_equal :PRE_OPERATIONAL, task.read_toplevel_state
@@ -362,6 +362,37 @@ def write_fixture_conf(content)
             end
         end
 
+        it "only writes the properties that changed in diff mode" do
+            conf.load_from_yaml(File.join(data_dir, "configurations", "base_config.yml"))
+            task = start_and_get(
+                { "orogen_runkit_tests::Configurations" => "conf" }, "conf"
+            )
+
+            first = conf.apply(task, "default", diff: true)
+            assert_equal 0, first.skipped
+            second = conf.apply(task, "default", diff: true)
+            assert_equal 0, second.written
+            assert_equal first.written, second.skipped
+
+            result = conf.apply(task, %w[default compound], diff: true)
+            assert_equal 1, result.written
+            verify_applied_conf task, "compound" do
+                assert_conf_value "intg", "/int32_t", Typelib::NumericType, 30
+            end
+        end
+
+        it "writes a property again in diff mode if it got written in between" do
+            conf.load_from_yaml(File.join(data_dir, "configurations", "base_config.yml"))
+            task = start_and_get(
+                { "orogen_runkit_tests::Configurations" => "conf" }, "conf"
+            )
+
+            conf.apply(task, "default", diff: true)
+            task.property("intg").write(0)
+            result = conf.apply(task, "default", diff: true)
+            assert_equal 1, result.written
+        end
+
         it "should be able to apply complex configuration on the task" do
             conf.load_from_yaml(File.join(data_dir, "configurations", "complex_config.yml"))
 
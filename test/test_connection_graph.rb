@@ -0,0 +1,81 @@
+# frozen_string_literal: true
+
+require "runkit/test"
+
+module Runkit
+    describe ConnectionGraph do
+        before do
+            task = new_ruby_task_context "source"
+            @source = task.create_output_port "out", "/double"
+            task = new_ruby_task_context "sink"
+            @sink = task.create_input_port "in", "/double"
+            task = new_ruby_task_context "other_sink"
+            @other_sink = task.create_input_port "in", "/double"
+            @graph = ConnectionGraph.new
+        end
+
+        it "creates the desired connections" do
+            result = @graph.apply([[@source, @sink, {}]])
+            assert result.success?
+            assert_equal [%w[source.out sink.in]], @graph.applied.keys
+            assert @sink.connected?
+        end
+
+        it "only touches the connections that changed" do
+            @graph.apply([[@source, @sink, {}], [@source, @other_sink, {}]])
+            plan = @graph.plan(
+                [[@source, @sink, { type: :data }],
+                 [@source, @other_sink, { type: :buffer, size: 10 }]]
+            )
+            assert plan.added.empty?
+            assert plan.removed.empty?
+            assert_equal [%w[source.out other_sink.in]], plan.reconnected.map(&:key)
+        end
+
+        it "removes the connections that are not desired anymore" do
+            @graph.apply([[@source, @sink, {}], [@source, @other_sink, {}]])
+            result = @graph.apply([[@source, @other_sink, {}]])
+            assert_equal [%w[source.out sink.in]], result.plan.removed.map(&:key)
+            refute @sink.connected?
+            assert @other_sink.connected?
+        end
+
+        it "re-creates the connections whose policy changed" do
+            @graph.apply([[@source, @sink, {}]])
+            result = @graph.apply([[@source, @sink, { type: :buffer, size: 10 }]])
+            assert result.success?
+            assert_equal :buffer, @graph.applied[%w[source.out sink.in]].policy[:type]
+            assert @sink.connected?
+        end
+
+        it "reports the connections that could not be created and retries them" do
+            @sink.task.dispose
+            result = @graph.apply([[@source, @sink, {}], [@source, @other_sink, {}]])
+            assert_equal [%w[source.out sink.in]], result.errors.keys.map(&:key)
+            assert_equal [%w[source.out other_sink.in]], @graph.applied.keys
+            assert_equal [%w[source.out sink.in]],
+                         @graph.plan([[@source, @sink, {}], [@source, @other_sink, {}]])
+                               .added.map(&:key)
+        end
+
+        it "forgets the connections whose ports got disconnected" do
+            @graph.apply([[@source, @sink, {}]])
+            @sink.disconnect_all
+            result = @graph.apply([[@source, @sink, {}]], check: true)
+            assert_equal [%w[source.out sink.in]], result.plan.added.map(&:key)
+            assert @sink.connected?
+        end
+
+        it "queries each port only once" do
+            @graph.apply([[@source, @sink, {}], [@source, @other_sink, {}]])
+            queried = nil
+            flexmock(Runkit).should_receive(:connected_all).once
+                            .and_return do |ports, *|
+                                queried = ports.map(&:full_name)
+                                [true] * ports.size
+                            end
+            assert_equal [], @graph.forget_disconnected
+            assert_equal %w[source.out sink.in other_sink.in], queried
+        end
+    end
+end
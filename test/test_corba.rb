@@ -13,4 +13,67 @@
         types = Runkit::CORBA.transportable_type_names
         assert(types.include?("/base/geometry/Spline<3>"))
     end
+
+    it "passes the endpoint options to the ORB" do
+        flexmock(Runkit::CORBA)
+            .should_receive(:do_initialize)
+            .with(["-ORBendPoint", "giop:unix:", "-ORBendPoint", "giop:tcp::",
+                   "-ORBendPointPublish", "all(addr)",
+                   "-ORBclientTransportRule", "* unix,tcp",
+                   "-ORBgiopMaxMsgSize", "1024"])
+            .once
+        Runkit::CORBA.initialize(unix: true, orb_options: { giopMaxMsgSize: 1024 })
+    end
+
+    it "sets a call timeout for the current thread only" do
+        Runkit::CORBA.with_call_timeout(0.5) do
+            assert_equal 500, Thread.current[:__runkit_call_timeout]
+            assert_nil Thread.new { Thread.current[:__runkit_call_timeout] }.value
+        end
+        assert_nil Thread.current[:__runkit_call_timeout]
+    end
+
+    it "applies per-call timeouts to remote calls" do
+        local = Runkit::RubyTasks::TaskContext.new("per_call_timeout")
+        task = Runkit::TaskContext.new(local.ior, name: local.name)
+        assert_equal :PRE_OPERATIONAL, task.read_toplevel_state(timeout: 1)
+        task.configure(timeout: 1)
+        assert_equal :STOPPED, task.read_toplevel_state(timeout: 1)
+    ensure
+        local&.dispose
+    end
+
+    it "raises TimeoutError within the timeout if an operation takes longer" do
+        r, w = IO.pipe
+        pid = spawn(
+            { "RUBYLIB" => $LOAD_PATH.join(File::PATH_SEPARATOR) },
+            RbConfig.ruby, "-rrunkit", "-e", <<~SCRIPT, out: w
+                Runkit.load
+                Runkit::CORBA.initialize
+                task = Runkit::RubyTasks::TaskContext.new(
+                    "slow_operation", register_on_name_server: false
+                )
+                STDOUT.puts task.ior
+                STDOUT.flush
+                sleep
+            SCRIPT
+        )
+        w.close
+        ior = r.gets.chomp
+        task = Runkit::TaskContext.new(ior, name: "slow_operation")
+        op = task.operation("getModelName")
+
+        # Stop the process that serves the task, so that the operation does
+        # not return until it gets resumed
+        Process.kill "STOP", pid
+        start = Time.now
+        assert_raises(Runkit::CORBA::TimeoutError) { op.callop(timeout: 0.5) }
+        assert_operator Time.now - start, :<, 2
+    ensure
+        if pid
+            Process.kill "KILL", pid
+            Process.waitpid pid
+        end
+        r&.close
+    end
 end
@@ -129,6 +129,71 @@ def dataflow_stress_test_count
                 end
             end
 
+            describe "Runkit.connect_all" do
+                attr_reader :other_sink
+                before do
+                    task = new_ruby_task_context "other_sink"
+                    @other_sink = task.create_input_port "in", "/double"
+                end
+
+                it "creates all the connections" do
+                    results = Runkit.connect_all(
+                        [[source, sink, {}], [source, other_sink, { type: :buffer, size: 10 }]]
+                    )
+                    assert_equal [true, true], results
+                    assert sink.connected?
+                    assert other_sink.connected?
+                end
+
+                it "reports the connections that failed, and creates the others" do
+                    sink.task.dispose
+                    results = Runkit.connect_all([[source, sink, {}], [source, other_sink, {}]])
+                    assert_kind_of ComError, results[0]
+                    assert_match(/^failed to connect #{source.full_name} => /,
+                                 results[0].message)
+                    assert_equal true, results[1]
+                    assert other_sink.connected?
+                end
+
+                it "validates all the edges before creating any connection" do
+                    policy = Port.prepare_policy
+                    assert_raises(TypeError) do
+                        Runkit.do_connect_all(
+                            [[source, sink, policy], [source, other_sink, 42]]
+                        )
+                    end
+                    refute sink.connected?
+                    refute other_sink.connected?
+                end
+
+                it "refuses connecting to another OutputPort" do
+                    assert_raises(ArgumentError) do
+                        Runkit.connect_all([[source, source, {}]])
+                    end
+                end
+
+                it "disconnects the given pairs of ports" do
+                    Runkit.connect_all([[source, sink, {}], [source, other_sink, {}]])
+                    assert_equal [true], Runkit.disconnect_all([[source, sink]])
+                    refute sink.connected?
+                    assert other_sink.connected?
+                end
+
+                it "disconnects all the connections of the given ports" do
+                    Runkit.connect_all([[source, sink, {}], [source, other_sink, {}]])
+                    assert_equal [true, true], Runkit.disconnect_ports([sink, other_sink])
+                    refute source.connected?
+                end
+
+                it "tests whether many ports are connected at once" do
+                    Runkit.connect_all([[source, sink, {}]])
+                    other_sink.task.dispose
+                    results = Runkit.connected_all([source, sink, other_sink])
+                    assert_equal [true, true], results[0, 2]
+                    assert_kind_of ComError, results[2]
+                end
+            end
+
             it "behaves correctly if connections are modified while running" do
                 last = nil
 
@@ -79,6 +79,38 @@ module Runkit
             assert_equal(80, prop.read.tv_sec)
         end
 
+        it "reads many properties at once" do
+            t = start_and_get({ "orogen_runkit_tests::Properties" => "test" }, "test")
+            values = t.raw_read_properties(%w[prop1 prop2 prop3])
+            assert_equal 21, Typelib.to_ruby(values["prop1"]).tv_sec
+            assert_equal 84, Typelib.to_ruby(values["prop2"])
+            assert_equal "42", Typelib.to_ruby(values["prop3"])
+        end
+
+        it "writes many properties at once" do
+            t = start_and_get({ "orogen_runkit_tests::Properties" => "test" }, "test")
+            t.configure
+            results = t.write_properties(
+                "prop2" => 42, "prop3" => "84", "dynamic_prop" => "12345"
+            )
+            assert_equal({ "prop2" => true, "prop3" => true, "dynamic_prop" => true },
+                         results)
+            assert_equal 42, t.property("prop2").read
+            assert_equal "84", t.property("prop3").read
+            assert t.dynamic_prop_setter_called
+        end
+
+        it "names the property and the task in the errors of a bulk write" do
+            t = start_and_get({ "orogen_runkit_tests::Properties" => "test" }, "test")
+            t.configure
+            results = t.write_properties("prop2" => 42, "dynamic_prop" => "")
+            assert_equal true, results["prop2"]
+            error = results["dynamic_prop"]
+            assert_kind_of Runkit::PropertyChangeRejected, error
+            assert_match(/^failed to write property dynamic_prop on task test: /,
+                         error.message)
+        end
+
         it "does not call the setter operation of a dynamic property if the task is not configured" do
             t = start_and_get({ "orogen_runkit_tests::Properties" => "test" }, "test")
             t.property("dynamic_prop").write("12345")
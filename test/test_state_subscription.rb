@@ -0,0 +1,99 @@
+# frozen_string_literal: true
+
+require "runkit/test"
+
+module Runkit
+    describe StateSubscriptions do
+        before do
+            @subscriptions = StateSubscriptions.new
+            local = new_ruby_task_context
+            @task = TaskContext.new(local.ior, name: local.name)
+        end
+
+        after do
+            @subscriptions.stop
+        end
+
+        def dispatch_until(queue, count)
+            deadline = Time.now + 5
+            while queue.size < count
+                flunk "timed out waiting for #{count} transitions" if Time.now > deadline
+                @subscriptions.dispatch(timeout: 0.1)
+            end
+            Array.new(queue.size) { queue.pop }
+        end
+
+        it "dispatches every state the task goes through" do
+            queue = Queue.new
+            @subscriptions.subscribe(@task, queue: queue)
+            @task.configure
+            @task.start
+            @task.stop
+
+            transitions = dispatch_until(queue, 4)
+            assert_equal %I[PRE_OPERATIONAL STOPPED RUNNING STOPPED],
+                         transitions.map(&:state)
+            assert(transitions.all? { |t| t.task == @task })
+            assert transitions.last.latency >= 0
+        end
+
+        it "shares a single reader between the subscriptions of a task" do
+            received = []
+            @subscriptions.subscribe(@task) { |t| received << [:a, t.state] }
+            @subscriptions.subscribe(@task) { |t| received << [:b, t.state] }
+            @subscriptions.dispatch
+            assert_equal [%I[a PRE_OPERATIONAL], %I[b PRE_OPERATIONAL]], received
+        end
+
+        it "disposes of the reader when the last subscriber is removed" do
+            queue = @subscriptions.subscribe(@task, queue: Queue.new)
+            @subscriptions.unsubscribe(@task, queue)
+            assert @subscriptions.empty?
+        end
+
+        it "returns right away if nothing is subscribed" do
+            assert_equal [], @subscriptions.dispatch(timeout: nil)
+        end
+
+        it "does not block subscriptions while waiting for a change" do
+            queue = @subscriptions.subscribe(@task, queue: Queue.new)
+            @subscriptions.dispatch
+            assert_equal :PRE_OPERATIONAL, queue.pop.state
+            dispatcher = Thread.new { @subscriptions.dispatch(timeout: 5) }
+            sleep 0.1
+
+            other = new_ruby_task_context
+            start = Time.now
+            @subscriptions.subscribe(other, queue: Queue.new)
+            assert_operator Time.now - start, :<, 1
+
+            @task.configure
+            dispatcher.join
+            assert_equal :STOPPED, queue.pop.state
+        end
+
+        it "polls from the thread forbidden for blocking calls" do
+            @subscriptions.subscribe(@task, queue: Queue.new)
+            @subscriptions.dispatch
+            Runkit.forbid_blocking_calls
+            assert_equal [], @subscriptions.dispatch(timeout: 0)
+            assert_raises(BlockingCallInForbiddenThread) do
+                @subscriptions.dispatch(timeout: 0.01)
+            end
+        ensure
+            Runkit.allow_blocking_calls
+        end
+
+        it "dispatches from a background thread" do
+            queue = Queue.new
+            @task.on_state_change(queue: queue)
+            Runkit.state_subscriptions.start
+            @task.configure
+            assert_equal :PRE_OPERATIONAL, queue.pop.state
+            assert_equal :STOPPED, queue.pop.state
+        ensure
+            Runkit.state_subscriptions.stop
+            Runkit.state_subscriptions.unsubscribe(@task, queue)
+        end
+    end
+end
@@ -235,6 +235,107 @@ module Runkit
             assert_equal "orogen_runkit_tests::Echo", t.getModelName
         end
 
+        it "builds a model of its whole interface in one call" do
+            task = new_remote_task_context do |t|
+                t.create_input_port "in", "/base/Vector3d"
+                t.create_output_port "out", "/int32_t"
+                t.create_property "prop", "/double"
+                t.create_attribute "attr", "/int32_t"
+            end
+
+            model = task.introspect
+            assert model.find_port("in").input?
+            assert model.find_port("out").output?
+            assert_equal "/int32_t", model.find_port("out").type.name
+            assert_equal "/double", model.find_property("prop").type.name
+            assert_equal "/int32_t", model.find_attribute("attr").type.name
+            assert model.find_operation("getModelName")
+        end
+
+        it "resolves an operation signature only once" do
+            local = new_ruby_task_context
+            task = TaskContext.new(local.ior, name: local.name)
+            op = task.operation("getModelName")
+            local.dispose
+
+            cached = task.operation("getModelName")
+            assert_equal op.orocos_return_typenames, cached.orocos_return_typenames
+            assert_raises(CORBA::ComError) { task.operation("__orogen_getTID") }
+        end
+
+        it "reads its state and calls operations in the background" do
+            project = OroGen::Spec::Project.new(Runkit.default_loader)
+            model = OroGen::Spec::TaskContext.new(project, "myModel")
+            local = new_ruby_task_context(model: model)
+            task = TaskContext.new(local.ior, name: local.name)
+
+            calls = Array.new(20) { task.read_toplevel_state_async }
+            calls << task.operation("getModelName").callop_async
+            assert_equal [:PRE_OPERATIONAL] * 20, calls[0, 20].map(&:value)
+            assert_equal "myModel", calls.last.value
+            assert calls.all?(&:done?)
+        end
+
+        it "raises the error of a failed background call from #value" do
+            local = new_ruby_task_context
+            task = TaskContext.new(local.ior, name: local.name)
+            local.dispose
+
+            call = task.read_toplevel_state_async
+            assert call.wait(10)
+            assert_raises(CORBA::ComError) { call.value }
+        end
+
+        it "reads the state of many tasks at once" do
+            tasks = Array.new(3) { |i| new_ruby_task_context("states_of_#{i}") }
+            remote = tasks.map { |t| TaskContext.new(t.ior, name: t.name) }
+            remote[1].configure
+            tasks[2].dispose
+
+            states = Runkit.states_of(remote)
+            assert_equal :PRE_OPERATIONAL, states[remote[0]]
+            assert_equal :STOPPED, states[remote[1]]
+            assert_kind_of CORBA::ComError, states[remote[2]]
+        end
+
+        it "shares the underlying proxy between the task contexts of the same IOR" do
+            task = new_ruby_task_context
+            count = CORBA.interned_task_context_count
+            proxies = Array.new(3) { TaskContext.new(task.ior, name: task.name) }
+            assert_equal count, CORBA.interned_task_context_count
+            proxies[0].configure
+            assert(proxies.all? { |p| p.read_toplevel_state == :STOPPED })
+        end
+
+        it "resolves the task again after a communication error" do
+            task = new_ruby_task_context
+            proxy = TaskContext.new(task.ior, name: task.name)
+            task.instance_variable_get(:@local_task).dispose
+            assert_raises(CORBA::ComError) { proxy.read_toplevel_state }
+            assert_raises(CORBA::ComError) do
+                TaskContext.new(task.ior, name: task.name)
+            end
+        end
+
+        it "forgets the proxy when a direct call fails with a communication error" do
+            task = new_ruby_task_context
+            proxy = TaskContext.new(task.ior, name: task.name)
+            task.instance_variable_get(:@local_task).dispose
+            count = CORBA.interned_task_context_count
+            assert_raises(CORBA::ComError) { proxy.do_state }
+            assert_equal count - 1, CORBA.interned_task_context_count
+        end
+
+        it "forgets the proxies of the tasks that failed in a batched call" do
+            tasks = Array.new(2) { |i| new_ruby_task_context("forget_batched_#{i}") }
+            remote = tasks.map { |t| TaskContext.new(t.ior, name: t.name) }
+            tasks[1].instance_variable_get(:@local_task).dispose
+            count = CORBA.interned_task_context_count
+            states = Runkit.states_of(remote)
+            assert_kind_of CORBA::ComError, states[remote[1]]
+            assert_equal count - 1, CORBA.interned_task_context_count
+        end
+
         def new_remote_task_context
             task = new_ruby_task_context
             yield(task) if block_given?